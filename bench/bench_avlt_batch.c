@@ -0,0 +1,70 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_avlt_batch.c
+
+Point lookups one at a time versus avlt_search_batch().
+
+usage: bench_avlt_batch [num_keys] [num_lookups] [batch_size]
+
+\**************************************************/
+
+#include "c_avlt.h"
+#include "bench_util.h"
+
+int main(int argc, char **argv)
+{
+	size_t _n = bench_arg_size(argc, argv, 1, 4000000);
+	size_t _lookups = bench_arg_size(argc, argv, 2, 4000000);
+	size_t _batch = bench_arg_size(argc, argv, 3, 256);
+	uint *_keys = bench_unique_keys(_n, 0x1234);
+	uint *_probe = (uint *) malloc(_lookups * sizeof(uint));
+	void **_out = (void **) malloc(_batch * sizeof(void *));
+	uint64_t _seed = 0x5678;
+	uintptr_t _sum = 0;
+	time_probe_t _tp;
+	avlt_t _avlt;
+	size_t _i;
+	size_t _j;
+
+	avlt_init_pool(&_avlt, 0);
+	for (_i = 0; _i < _n; _i++) {
+		avlt_insert(&_avlt, _keys[_i], (void *) (uintptr_t) _keys[_i]);
+	}
+	// Half hits, half misses (keys are odd).
+	for (_i = 0; _i < _lookups; _i++) {
+		_probe[_i] = _keys[bench_rand(&_seed) % _n] + (_i & 1);
+	}
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _lookups; _i++) {
+		_sum += (uintptr_t) avlt_search(&_avlt, _probe[_i]);
+	}
+	timer_stop(&_tp);
+	bench_report("avlt_search", &_tp, _lookups);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _lookups; _i += _batch) {
+		size_t _cnt = (_lookups - _i < _batch) ? _lookups - _i : _batch;
+		avlt_search_batch(&_avlt, _probe + _i, _out, _cnt);
+		for (_j = 0; _j < _cnt; _j++) {
+			_sum -= (uintptr_t) _out[_j];
+		}
+	}
+	timer_stop(&_tp);
+	bench_report("avlt_search_batch", &_tp, _lookups);
+
+	if (_sum != 0) {
+		fprintf(stderr, "ERROR: batch and single lookups disagree\n");
+		return 1;
+	}
+
+	avlt_destroy_pool(&_avlt);
+	free(_out);
+	free(_probe);
+	free(_keys);
+	return 0;
+}
@@ -0,0 +1,149 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_avlt_conc.c
+
+Read throughput of avlt_conc_t against a mutex-wrapped
+avlt_t, for 1, 2, 4, ... reader threads while one writer
+keeps deleting and re-inserting keys.
+
+usage: bench_avlt_conc [num_keys] [lookups_per_thread] [max_threads]
+                       [writer_pause_us]
+
+\**************************************************/
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "c_avlt.h"
+#include "c_avlt_conc.h"
+#include "bench_util.h"
+
+typedef struct bench_ctx {
+	avlt_conc_t *_conc;
+	avlt_t *_avlt;		// used with _lock when _conc is NULL
+	pthread_mutex_t *_lock;
+	uint *_keys;
+	size_t _n;
+	size_t _ops;
+	volatile int *_stop;
+	useconds_t _pause_us;
+	uint64_t _seed;
+	time_probe_t _tp;
+} bench_ctx_t;
+
+static void *reader(void *_arg)
+{
+	bench_ctx_t *_ctx = (bench_ctx_t *) _arg;
+	uintptr_t _sum = 0;
+	size_t _i;
+
+	bench_probe_reset(&_ctx->_tp);
+	timer_start(&_ctx->_tp);
+	for (_i = 0; _i < _ctx->_ops; _i++) {
+		uint _key = _ctx->_keys[bench_rand(&_ctx->_seed) % _ctx->_n];
+		if (_ctx->_conc != NULL) {
+			_sum += (uintptr_t) avlt_conc_search(_ctx->_conc, _key);
+		} else {
+			pthread_mutex_lock(_ctx->_lock);
+			_sum += (uintptr_t) avlt_search(_ctx->_avlt, _key);
+			pthread_mutex_unlock(_ctx->_lock);
+		}
+	}
+	timer_stop(&_ctx->_tp);
+	return (void *) _sum;
+}
+
+static void *writer(void *_arg)
+{
+	bench_ctx_t *_ctx = (bench_ctx_t *) _arg;
+	size_t _i = 0;
+
+	while (!*_ctx->_stop) {
+		uint _key = _ctx->_keys[_i++ % _ctx->_n];
+		if (_ctx->_conc != NULL) {
+			avlt_conc_delete(_ctx->_conc, _key);
+			avlt_conc_insert(_ctx->_conc, _key,
+					 (void *) (uintptr_t) _key);
+		} else {
+			pthread_mutex_lock(_ctx->_lock);
+			avlt_delete(_ctx->_avlt, _key);
+			avlt_insert(_ctx->_avlt, _key, (void *) (uintptr_t) _key);
+			pthread_mutex_unlock(_ctx->_lock);
+		}
+		if (_ctx->_pause_us > 0) {
+			usleep(_ctx->_pause_us);
+		}
+	}
+	return NULL;
+}
+
+static void run(const char *_label, avlt_conc_t *_conc, avlt_t *_avlt,
+		uint *_keys, size_t _n, size_t _ops, int _threads,
+		useconds_t _pause_us)
+{
+	pthread_mutex_t _lock = PTHREAD_MUTEX_INITIALIZER;
+	pthread_t _tids[_threads + 1];
+	bench_ctx_t _ctx[_threads + 1];
+	volatile int _stop = 0;
+	double _mops = 0;
+	int _t;
+
+	for (_t = 0; _t <= _threads; _t++) {
+		_ctx[_t]._conc = _conc;
+		_ctx[_t]._avlt = _avlt;
+		_ctx[_t]._lock = &_lock;
+		_ctx[_t]._keys = _keys;
+		_ctx[_t]._n = _n;
+		_ctx[_t]._ops = _ops;
+		_ctx[_t]._stop = &_stop;
+		_ctx[_t]._pause_us = _pause_us;
+		_ctx[_t]._seed = 0x9E3779B97F4A7C15ULL * (_t + 1);
+	}
+	pthread_create(&_tids[_threads], NULL, writer, &_ctx[_threads]);
+	for (_t = 0; _t < _threads; _t++) {
+		pthread_create(&_tids[_t], NULL, reader, &_ctx[_t]);
+	}
+	for (_t = 0; _t < _threads; _t++) {
+		pthread_join(_tids[_t], NULL);
+		_mops += (double) _ops * 1000.0 /
+			(double) _ctx[_t]._tp.sum_nano_lapse;
+	}
+	_stop = 1;
+	pthread_join(_tids[_threads], NULL);
+
+	fprintf(stdout, "%-8s readers %3d  %10.3f Mops/s total\n", _label,
+		_threads, _mops);
+	fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+	size_t _n = bench_arg_size(argc, argv, 1, 1000000);
+	size_t _ops = bench_arg_size(argc, argv, 2, 1000000);
+	int _max_threads = (int) bench_arg_size(argc, argv, 3, 16);
+	useconds_t _pause_us = (useconds_t) bench_arg_size(argc, argv, 4, 10);
+	uint *_keys = bench_unique_keys(_n, 0x1234);
+	avlt_conc_t _conc;
+	avlt_t _avlt;
+	size_t _i;
+	int _t;
+
+	avlt_conc_init(&_conc, 0);
+	avlt_init_pool(&_avlt, 0);
+	for (_i = 0; _i < _n; _i++) {
+		avlt_conc_insert(&_conc, _keys[_i], (void *) (uintptr_t) _keys[_i]);
+		avlt_insert(&_avlt, _keys[_i], (void *) (uintptr_t) _keys[_i]);
+	}
+
+	for (_t = 1; _t <= _max_threads; _t *= 2) {
+		run("mutex", NULL, &_avlt, _keys, _n, _ops, _t, _pause_us);
+		run("seqlock", &_conc, NULL, _keys, _n, _ops, _t, _pause_us);
+	}
+
+	avlt_destroy_pool(&_avlt);
+	avlt_conc_destroy(&_conc);
+	free(_keys);
+	return 0;
+}
@@ -0,0 +1,92 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_avlt_finger.c
+
+Inserts and lookups from the root against finger mode on
+sequential, near-sorted and random key streams.
+
+usage: bench_avlt_finger [num_keys] [shuffle_window]
+
+\**************************************************/
+
+#include "c_avlt.h"
+#include "bench_util.h"
+
+static void _run(const char *_stream, const uint *_keys, size_t _n,
+		 bool _finger)
+{
+	char _name[64];
+	uintptr_t _sum = 0;
+	time_probe_t _tp;
+	avlt_t _avlt;
+	size_t _i;
+
+	avlt_init_pool(&_avlt, 0);
+	if (_finger) {
+		avlt_enable_finger(&_avlt);
+	}
+
+	snprintf(_name, sizeof(_name), "%s insert%s", _stream,
+		 _finger ? " (finger)" : "");
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		avlt_insert(&_avlt, _keys[_i], (void *) (uintptr_t) _keys[_i]);
+	}
+	timer_stop(&_tp);
+	bench_report(_name, &_tp, _n);
+
+	snprintf(_name, sizeof(_name), "%s search%s", _stream,
+		 _finger ? " (finger)" : "");
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		_sum += (uintptr_t) avlt_search(&_avlt, _keys[_i]) - _keys[_i];
+	}
+	timer_stop(&_tp);
+	bench_report(_name, &_tp, _n);
+
+	if (_sum != 0) {
+		fprintf(stderr, "ERROR: lookups returned wrong values\n");
+		exit(1);
+	}
+	avlt_destroy_pool(&_avlt);
+}
+
+int main(int argc, char **argv)
+{
+	size_t _n = bench_arg_size(argc, argv, 1, 2000000);
+	size_t _window = bench_arg_size(argc, argv, 2, 16);
+	uint *_keys = (uint *) calloc(_n, sizeof(uint));
+	uint *_random = bench_unique_keys(_n, 0x1234);
+	uint64_t _seed = 0x5678;
+	size_t _i;
+
+	for (_i = 0; _i < _n; _i++) {
+		_keys[_i] = 2 * _i + 1;
+	}
+	_run("sequential", _keys, _n, false);
+	_run("sequential", _keys, _n, true);
+
+	// Sorted, then shuffled within consecutive windows, like timestamps
+	// arriving slightly out of order.
+	for (_i = 0; _i < _n; _i++) {
+		size_t _start = _i - _i % _window;
+		size_t _len = (_start + _window <= _n) ? _window : _n - _start;
+		size_t _j = _start + bench_rand(&_seed) % _len;
+		uint _tmp = _keys[_i];
+		_keys[_i] = _keys[_j];
+		_keys[_j] = _tmp;
+	}
+	_run("near-sorted", _keys, _n, false);
+	_run("near-sorted", _keys, _n, true);
+
+	_run("random", _random, _n, false);
+	_run("random", _random, _n, true);
+
+	free(_random);
+	free(_keys);
+	return 0;
+}
@@ -0,0 +1,79 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_avlt_frozen.c
+
+Lookups on a live avlt_t against its Eytzinger snapshot.
+
+usage: bench_avlt_frozen [num_keys] [num_lookups]
+
+\**************************************************/
+
+#include "c_avlt.h"
+#include "c_avlt_frozen.h"
+#include "bench_util.h"
+
+int main(int argc, char **argv)
+{
+	size_t _n = bench_arg_size(argc, argv, 1, 4000000);
+	size_t _lookups = bench_arg_size(argc, argv, 2, 4000000);
+	uint *_keys = bench_unique_keys(_n, 0x1234);
+	uint *_probe = (uint *) malloc(_lookups * sizeof(uint));
+	void **_out = (void **) malloc(_lookups * sizeof(void *));
+	uint64_t _seed = 0x5678;
+	uintptr_t _sum = 0;
+	time_probe_t _tp;
+	avlt_t _avlt;
+	avlt_frozen_t _frozen;
+	size_t _i;
+
+	avlt_init_pool(&_avlt, 0);
+	for (_i = 0; _i < _n; _i++) {
+		avlt_insert(&_avlt, _keys[_i], (void *) (uintptr_t) _keys[_i]);
+	}
+	for (_i = 0; _i < _lookups; _i++) {
+		_probe[_i] = _keys[bench_rand(&_seed) % _n] + (_i & 1);
+	}
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	avlt_freeze(&_avlt, &_frozen);
+	timer_stop(&_tp);
+	bench_report("avlt_freeze", &_tp, _n);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _lookups; _i++) {
+		_sum += (uintptr_t) avlt_search(&_avlt, _probe[_i]);
+	}
+	timer_stop(&_tp);
+	bench_report("avlt_search", &_tp, _lookups);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	avlt_search_batch(&_avlt, _probe, _out, _lookups);
+	timer_stop(&_tp);
+	bench_report("avlt_search_batch", &_tp, _lookups);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _lookups; _i++) {
+		_sum -= (uintptr_t) avlt_frozen_search(&_frozen, _probe[_i]);
+	}
+	timer_stop(&_tp);
+	bench_report("avlt_frozen_search", &_tp, _lookups);
+	fprintf(stdout, "bytes/entry avlt %zu frozen %zu\n",
+		sizeof(_avlt_node_t), sizeof(uint) + sizeof(void *));
+
+	if (_sum != 0) {
+		fprintf(stderr, "ERROR: frozen and live lookups disagree\n");
+		return 1;
+	}
+	avlt_frozen_destroy(&_frozen);
+	avlt_destroy_pool(&_avlt);
+	free(_out);
+	free(_probe);
+	free(_keys);
+	return 0;
+}
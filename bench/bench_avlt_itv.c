@@ -0,0 +1,112 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_avlt_itv.c
+
+Overlap queries on the interval tree against scanning every
+stored interval.
+
+usage: bench_avlt_itv [num_intervals] [num_queries] [max_len]
+
+\**************************************************/
+
+#include "c_avlt_itv.h"
+#include "bench_util.h"
+
+#define _SPAN (1ULL << 32)
+
+int main(int argc, char **argv)
+{
+	size_t _n = bench_arg_size(argc, argv, 1, 1000000);
+	size_t _queries = bench_arg_size(argc, argv, 2, 100000);
+	uint64_t _max_len = bench_arg_size(argc, argv, 3, 100000);
+	uint64_t *_start = (uint64_t *) malloc(_n * sizeof(uint64_t));
+	uint64_t *_end = (uint64_t *) malloc(_n * sizeof(uint64_t));
+	uint64_t *_lo = (uint64_t *) malloc(_queries * sizeof(uint64_t));
+	uint64_t *_hi = (uint64_t *) malloc(_queries * sizeof(uint64_t));
+	uint64_t _seed = 0x1234;
+	size_t _tree_matches = 0;
+	size_t _batch_matches;
+	size_t _stab_matches = 0;
+	size_t _scan_matches = 0;
+	size_t _scanned;
+	time_probe_t _tp;
+	avlt_itv_t _itv;
+	size_t _i;
+	size_t _j;
+
+	for (_i = 0; _i < _n; _i++) {
+		_start[_i] = bench_rand(&_seed) % _SPAN;
+		_end[_i] = _start[_i] + bench_rand(&_seed) % (_max_len + 1);
+	}
+	for (_i = 0; _i < _queries; _i++) {
+		_lo[_i] = bench_rand(&_seed) % _SPAN;
+		_hi[_i] = _lo[_i] + bench_rand(&_seed) % (_max_len + 1);
+	}
+
+	avlt_itv_init(&_itv);
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		avlt_itv_insert(&_itv, _start[_i], _end[_i],
+				(void *) (uintptr_t) (_i + 1));
+	}
+	timer_stop(&_tp);
+	bench_report("avlt_itv_insert", &_tp, _n);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _queries; _i++) {
+		_tree_matches += avlt_itv_overlap(&_itv, _lo[_i], _hi[_i],
+						  NULL, NULL);
+	}
+	timer_stop(&_tp);
+	bench_report("avlt_itv_overlap", &_tp, _queries);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	_batch_matches = avlt_itv_overlap_batch(&_itv, _lo, _hi, _queries,
+						NULL, NULL);
+	timer_stop(&_tp);
+	bench_report("avlt_itv_overlap_batch", &_tp, _queries);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _queries; _i++) {
+		_stab_matches += avlt_itv_stab(&_itv, _lo[_i], NULL, NULL);
+	}
+	timer_stop(&_tp);
+	bench_report("avlt_itv_stab", &_tp, _queries);
+
+	// The linear scan is slow, so it only runs a slice of the queries.
+	_scanned = (_queries < 1000) ? _queries : 1000;
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _scanned; _i++) {
+		for (_j = 0; _j < _n; _j++) {
+			_scan_matches += (_start[_j] <= _hi[_i] &&
+					  _end[_j] >= _lo[_i]);
+		}
+	}
+	timer_stop(&_tp);
+	bench_report("linear scan overlap", &_tp, _scanned);
+
+	fprintf(stdout, "matches/query overlap %.3f stab %.3f\n",
+		_queries ? (double) _tree_matches / _queries : 0,
+		_queries ? (double) _stab_matches / _queries : 0);
+	for (_i = 0; _i < _scanned; _i++) {
+		_scan_matches -= avlt_itv_overlap(&_itv, _lo[_i], _hi[_i],
+						  NULL, NULL);
+	}
+	if (_scan_matches != 0 || _batch_matches != _tree_matches) {
+		fprintf(stderr, "ERROR: interval tree and scan disagree\n");
+		return 1;
+	}
+	avlt_itv_clear(&_itv);
+	free(_hi);
+	free(_lo);
+	free(_end);
+	free(_start);
+	return 0;
+}
@@ -0,0 +1,87 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_avlt_mmap.c
+
+Restart cost of an index: rebuilding an avlt_t by inserting
+every entry against mapping a saved file, and lookups on the
+mapped index once it is open.
+
+usage: bench_avlt_mmap [num_keys] [num_lookups] [path]
+
+\**************************************************/
+
+#include "c_avlt.h"
+#include "c_avlt_frozen.h"
+#include "c_avlt_mmap.h"
+#include "bench_util.h"
+
+#include <unistd.h>
+
+int main(int argc, char **argv)
+{
+	size_t _n = bench_arg_size(argc, argv, 1, 4000000);
+	size_t _lookups = bench_arg_size(argc, argv, 2, 4000000);
+	const char *_path = (argc > 3) ? argv[3] : "bench_avlt_mmap.idx";
+	uint *_keys = bench_unique_keys(_n, 0x1234);
+	uint64_t _seed = 0x5678;
+	uintptr_t _sum = 0;
+	time_probe_t _tp;
+	avlt_t _avlt;
+	avlt_frozen_t _frozen;
+	size_t _i;
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	avlt_init_pool(&_avlt, 0);
+	for (_i = 0; _i < _n; _i++) {
+		avlt_insert(&_avlt, _keys[_i], (void *) (uintptr_t) _keys[_i]);
+	}
+	timer_stop(&_tp);
+	bench_report("rebuild by avlt_insert", &_tp, _n);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	if (avlt_save(&_avlt, _path) != 0) {
+		return 1;
+	}
+	timer_stop(&_tp);
+	bench_report("avlt_save", &_tp, _n);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	if (avlt_open_mmap(_path, &_frozen, 0) != 0) {
+		return 1;
+	}
+	timer_stop(&_tp);
+	bench_report("avlt_open_mmap", &_tp, 1);
+	avlt_frozen_destroy(&_frozen);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	if (avlt_open_mmap(_path, &_frozen, AVLT_MMAP_VERIFY) != 0) {
+		return 1;
+	}
+	timer_stop(&_tp);
+	bench_report("avlt_open_mmap verified", &_tp, 1);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _lookups; _i++) {
+		uint _key = _keys[bench_rand(&_seed) % _n];
+		_sum += (uintptr_t) avlt_frozen_search(&_frozen, _key) - _key;
+	}
+	timer_stop(&_tp);
+	bench_report("mapped avlt_frozen_search", &_tp, _lookups);
+
+	if (_sum != 0) {
+		fprintf(stderr, "ERROR: mapped lookups returned wrong values\n");
+		return 1;
+	}
+	avlt_frozen_destroy(&_frozen);
+	avlt_destroy_pool(&_avlt);
+	unlink(_path);
+	free(_keys);
+	return 0;
+}
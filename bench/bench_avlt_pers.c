@@ -0,0 +1,111 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_avlt_pers.c
+
+Snapshot cost and write overhead of the persistent AVLTree
+against a deep copy of an avlt_t.
+
+usage: bench_avlt_pers [num_keys] [writes_per_snapshot]
+
+\**************************************************/
+
+#include "c_avlt.h"
+#include "c_avlt_pers.h"
+#include "bench_util.h"
+
+#define _SNAPSHOTS (64)
+
+int main(int argc, char **argv)
+{
+	size_t _n = bench_arg_size(argc, argv, 1, 1000000);
+	size_t _every = bench_arg_size(argc, argv, 2, 1000);
+	uint *_keys = bench_unique_keys(_n, 0x1234);
+	uint *_sorted = (uint *) malloc(_n * sizeof(uint));
+	void **_values = (void **) malloc(_n * sizeof(void *));
+	time_probe_t _tp;
+	avlt_pers_t _pers;
+	avlt_pers_t _snap;
+	avlt_t _avlt;
+	avlt_t _copy;
+	avlt_itr_t _itr;
+	size_t _i;
+	size_t _j;
+
+	avlt_init_pool(&_avlt, 0);
+	avlt_pers_init(&_pers);
+	for (_i = 0; _i < _n; _i++) {
+		avlt_insert(&_avlt, _keys[_i], NULL);
+	}
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		avlt_pers_insert(&_pers, _keys[_i], NULL);
+	}
+	timer_stop(&_tp);
+	bench_report("avlt_pers_insert", &_tp, _n);
+
+	// Deep copy: what a point-in-time view costs without sharing.
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_j = 0; _j < _SNAPSHOTS; _j++) {
+		for (_i = 0, _itr = avlt_get_itr(&_avlt); _itr != NULL;
+		     _i++, _itr = avlt_iter_next(_itr)) {
+			_sorted[_i] = avlt_iter_key(_itr);
+			_values[_i] = avlt_iter_value(_itr);
+		}
+		avlt_init_pool(&_copy, 0);
+		avlt_build_sorted(&_copy, _sorted, _values, _n);
+		avlt_destroy_pool(&_copy);
+	}
+	timer_stop(&_tp);
+	bench_report("avlt deep copy", &_tp, _SNAPSHOTS);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_j = 0; _j < _SNAPSHOTS; _j++) {
+		avlt_pers_snapshot(&_pers, &_snap);
+		avlt_pers_release(&_snap);
+	}
+	timer_stop(&_tp);
+	bench_report("avlt_pers_snapshot", &_tp, _SNAPSHOTS);
+
+	// Delete and re-insert every key, holding a snapshot that is
+	// replaced every _every writes, so writes keep copying paths.
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		avlt_pers_delete(&_pers, _keys[_i]);
+		avlt_pers_insert(&_pers, _keys[_i], NULL);
+	}
+	timer_stop(&_tp);
+	bench_report("avlt_pers delete+insert", &_tp, _n);
+
+	avlt_pers_snapshot(&_pers, &_snap);
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		if (_i % _every == 0) {
+			avlt_pers_release(&_snap);
+			avlt_pers_snapshot(&_pers, &_snap);
+		}
+		avlt_pers_delete(&_pers, _keys[_i]);
+		avlt_pers_insert(&_pers, _keys[_i], NULL);
+	}
+	timer_stop(&_tp);
+	bench_report("avlt_pers delete+insert w/ snapshots", &_tp, _n);
+
+	if (_snap._size != _n || _pers._size != _n) {
+		fprintf(stderr, "ERROR: persistent tree lost entries\n");
+		return 1;
+	}
+	avlt_pers_release(&_snap);
+	avlt_pers_release(&_pers);
+	avlt_destroy_pool(&_avlt);
+	free(_values);
+	free(_sorted);
+	free(_keys);
+	return 0;
+}
@@ -0,0 +1,75 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_avlt_pool.c
+
+Insert/delete churn on a malloc-backed and a pooled avlt_t.
+
+usage: bench_avlt_pool [num_keys] [churn_ops]
+
+\**************************************************/
+
+#include "c_avlt.h"
+#include "bench_util.h"
+
+static void run(const char *_label, int _pooled, uint *_keys, size_t _n,
+		size_t _churn)
+{
+	avlt_t _avlt;
+	time_probe_t _tp;
+	size_t _i;
+	char _name[64];
+
+	if (_pooled) {
+		avlt_init_pool(&_avlt, 0);
+	} else {
+		avlt_init(&_avlt);
+	}
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		avlt_insert(&_avlt, _keys[_i], (void *) (uintptr_t) _keys[_i]);
+	}
+	timer_stop(&_tp);
+	snprintf(_name, sizeof(_name), "%s insert", _label);
+	bench_report(_name, &_tp, _n);
+
+	// Delete the oldest key and insert it again: the tree size stays
+	// constant and every op pair frees and allocates one node.
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _churn; _i++) {
+		uint _key = _keys[_i % _n];
+		avlt_delete(&_avlt, _key);
+		avlt_insert(&_avlt, _key, (void *) (uintptr_t) _key);
+	}
+	timer_stop(&_tp);
+	snprintf(_name, sizeof(_name), "%s delete+insert", _label);
+	bench_report(_name, &_tp, _churn * 2);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		avlt_delete(&_avlt, _keys[_i]);
+	}
+	timer_stop(&_tp);
+	snprintf(_name, sizeof(_name), "%s delete", _label);
+	bench_report(_name, &_tp, _n);
+
+	avlt_destroy_pool(&_avlt);
+}
+
+int main(int argc, char **argv)
+{
+	size_t _n = bench_arg_size(argc, argv, 1, 1000000);
+	size_t _churn = bench_arg_size(argc, argv, 2, 2000000);
+	uint *_keys = bench_unique_keys(_n, 0x1234);
+
+	run("malloc", 0, _keys, _n, _churn);
+	run("pool", 1, _keys, _n, _churn);
+
+	free(_keys);
+	return 0;
+}
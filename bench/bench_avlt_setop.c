@@ -0,0 +1,199 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_avlt_setop.c
+
+avlt_union, avlt_intersection and avlt_difference of a tree
+holding the multiples of 2 and one holding the multiples of
+3, with and without order statistics.  Results are checked
+against a merge of the key arrays, with avlt_rank and
+avlt_select on the order-statistic trees.  Then avlt_split
+and avlt_join at random keys, where a tree without order
+statistics has to count the entries of the left part.
+
+usage: bench_avlt_setop [num_keys] [num_splits]
+
+\**************************************************/
+
+#include "c_avlt.h"
+#include "bench_util.h"
+
+enum { _UNION, _INTERSECTION, _DIFFERENCE };
+
+static const char *_op_names[] = { "union", "intersection", "difference" };
+
+// Expected keys of _a _op _b, both sorted, into _out.  Returns how many.
+static size_t _merge(const uint *_a, size_t _na, const uint *_b, size_t _nb,
+		     int _op, uint *_out)
+{
+	size_t _i = 0;
+	size_t _j = 0;
+	size_t _n = 0;
+
+	while (_i < _na || _j < _nb) {
+		if (_j == _nb || (_i < _na && _a[_i] < _b[_j])) {
+			if (_op != _INTERSECTION) {
+				_out[_n++] = _a[_i];
+			}
+			_i++;
+		} else if (_i == _na || _b[_j] < _a[_i]) {
+			if (_op == _UNION) {
+				_out[_n++] = _b[_j];
+			}
+			_j++;
+		} else {
+			if (_op != _DIFFERENCE) {
+				_out[_n++] = _a[_i];
+			}
+			_i++;
+			_j++;
+		}
+	}
+	return _n;
+}
+
+static void _check(avlt_t *_avlt, const uint *_expect, size_t _n,
+		   bool _order_stat)
+{
+	avlt_itr_t _itr = avlt_get_itr(_avlt);
+	size_t _i;
+
+	if (_avlt->_size != _n) {
+		fprintf(stderr, "ERROR: size %zu, expected %zu\n",
+			_avlt->_size, _n);
+		exit(1);
+	}
+	for (_i = 0; _i < _n; _i++, _itr = avlt_iter_next(_itr)) {
+		if (_itr == NULL || avlt_iter_key(_itr) != _expect[_i]) {
+			fprintf(stderr, "ERROR: wrong key at %zu\n", _i);
+			exit(1);
+		}
+	}
+	if (!_order_stat) {
+		return;
+	}
+	for (_i = 0; _i < _n; _i += 1 + _n / 1000) {
+		if (avlt_rank(_avlt, _expect[_i]) != _i ||
+		    avlt_iter_key(avlt_select(_avlt, _i)) != _expect[_i]) {
+			fprintf(stderr, "ERROR: wrong rank or select at %zu\n",
+				_i);
+			exit(1);
+		}
+	}
+	if (_n > 0 && avlt_rank(_avlt, _expect[_n - 1] + 1) != _n) {
+		fprintf(stderr, "ERROR: wrong rank past the last key\n");
+		exit(1);
+	}
+}
+
+static void _run(const uint *_a, size_t _na, const uint *_b, size_t _nb,
+		 uint *_expect, int _op, bool _order_stat)
+{
+	char _name[64];
+	time_probe_t _tp;
+	avlt_t _dst;
+	avlt_t _src;
+	size_t _n = _merge(_a, _na, _b, _nb, _op, _expect);
+
+	avlt_init_pool(&_dst, 0);
+	avlt_init_shared_pool(&_src, &_dst);
+	if (_order_stat) {
+		avlt_enable_order_stat(&_dst);
+		avlt_enable_order_stat(&_src);
+	}
+	avlt_build_sorted(&_dst, _a, NULL, _na);
+	avlt_build_sorted(&_src, _b, NULL, _nb);
+
+	snprintf(_name, sizeof(_name), "%s%s", _op_names[_op],
+		 _order_stat ? " (order stat)" : "");
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	if (_op == _UNION) {
+		avlt_union(&_dst, &_src);
+	} else if (_op == _INTERSECTION) {
+		avlt_intersection(&_dst, &_src);
+	} else {
+		avlt_difference(&_dst, &_src);
+	}
+	timer_stop(&_tp);
+	bench_report(_name, &_tp, _na + _nb);
+
+	_check(&_dst, _expect, _n, _order_stat);
+	avlt_destroy_pool(&_src);
+	avlt_destroy_pool(&_dst);
+}
+
+// Splits the multiples of 2 at a random odd key and joins the parts
+// back around it, then deletes the key again.
+static void _run_split(const uint *_a, size_t _na, size_t _splits,
+		       bool _order_stat)
+{
+	char _name[64];
+	time_probe_t _tp;
+	uint64_t _seed = 0x9abc;
+	avlt_t _avlt;
+	avlt_t _left;
+	avlt_t _right;
+	size_t _i;
+
+	avlt_init(&_avlt);
+	if (_order_stat) {
+		avlt_enable_order_stat(&_avlt);
+	}
+	avlt_build_sorted(&_avlt, _a, NULL, _na);
+
+	snprintf(_name, sizeof(_name), "split+join%s",
+		 _order_stat ? " (order stat)" : "");
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _splits; _i++) {
+		uint _key = (uint) (2 * (bench_rand(&_seed) % _na) + 1);
+		avlt_split(&_avlt, _key, &_left, &_right);
+		if (_left._size != (_key + 1) / 2) {
+			fprintf(stderr, "ERROR: split at %u left %zu keys\n",
+				_key, _left._size);
+			exit(1);
+		}
+		avlt_join(&_left, _key, NULL, &_right);
+		_avlt = _left;
+		avlt_delete(&_avlt, _key);
+	}
+	timer_stop(&_tp);
+	bench_report(_name, &_tp, _splits);
+
+	if (_order_stat) {
+		_check(&_avlt, _a, _na, true);
+	}
+	avlt_clear(&_avlt);
+}
+
+int main(int argc, char **argv)
+{
+	size_t _n = bench_arg_size(argc, argv, 1, 2000000);
+	size_t _splits = bench_arg_size(argc, argv, 2, 100);
+	size_t _nb = _n * 2 / 3;
+	uint *_a = (uint *) malloc(_n * sizeof(uint));
+	uint *_b = (uint *) malloc(_nb * sizeof(uint));
+	uint *_expect = (uint *) malloc((_n + _nb) * sizeof(uint));
+	int _op;
+	size_t _i;
+
+	for (_i = 0; _i < _n; _i++) {
+		_a[_i] = (uint) (2 * _i);
+	}
+	for (_i = 0; _i < _nb; _i++) {
+		_b[_i] = (uint) (3 * _i);
+	}
+	for (_op = _UNION; _op <= _DIFFERENCE; _op++) {
+		_run(_a, _n, _b, _nb, _expect, _op, false);
+		_run(_a, _n, _b, _nb, _expect, _op, true);
+	}
+	_run_split(_a, _n, _splits, false);
+	_run_split(_a, _n, _splits, true);
+
+	free(_expect);
+	free(_b);
+	free(_a);
+	return 0;
+}
@@ -0,0 +1,159 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_avlt_shard.c
+
+Write-heavy scaling of one mutex-wrapped avlt_t against
+avlt_shard_t, single-key and batched, for 1 to 64 threads.
+Every thread inserts, looks up and deletes its own keys.
+
+usage: bench_avlt_shard [keys_per_thread] [num_shards] [max_threads]
+
+\**************************************************/
+
+#include <pthread.h>
+
+#include "c_avlt.h"
+#include "c_avlt_shard.h"
+#include "bench_util.h"
+
+#define BENCH_BATCH (256)
+
+enum bench_mode {
+	BENCH_LOCKED,
+	BENCH_SHARD,
+	BENCH_SHARD_BATCH,
+};
+
+typedef struct bench_ctx {
+	int _mode;
+	avlt_t *_avlt;
+	pthread_mutex_t *_lock;
+	avlt_shard_t *_avlt_shard;
+	uint *_keys;
+	size_t _n;
+	time_probe_t _tp;
+} bench_ctx_t;
+
+static void *worker(void *_arg)
+{
+	bench_ctx_t *_ctx = (bench_ctx_t *) _arg;
+	void *_values[BENCH_BATCH];
+	size_t _i;
+	size_t _j;
+
+	bench_probe_reset(&_ctx->_tp);
+	timer_start(&_ctx->_tp);
+	switch (_ctx->_mode) {
+	case BENCH_LOCKED:
+		for (_i = 0; _i < _ctx->_n; _i++) {
+			pthread_mutex_lock(_ctx->_lock);
+			avlt_insert(_ctx->_avlt, _ctx->_keys[_i], NULL);
+			pthread_mutex_unlock(_ctx->_lock);
+		}
+		for (_i = 0; _i < _ctx->_n; _i++) {
+			pthread_mutex_lock(_ctx->_lock);
+			avlt_search(_ctx->_avlt, _ctx->_keys[_i]);
+			pthread_mutex_unlock(_ctx->_lock);
+		}
+		for (_i = 0; _i < _ctx->_n; _i++) {
+			pthread_mutex_lock(_ctx->_lock);
+			avlt_delete(_ctx->_avlt, _ctx->_keys[_i]);
+			pthread_mutex_unlock(_ctx->_lock);
+		}
+		break;
+	case BENCH_SHARD:
+		for (_i = 0; _i < _ctx->_n; _i++) {
+			avlt_shard_insert(_ctx->_avlt_shard, _ctx->_keys[_i], NULL);
+		}
+		for (_i = 0; _i < _ctx->_n; _i++) {
+			avlt_shard_search(_ctx->_avlt_shard, _ctx->_keys[_i]);
+		}
+		for (_i = 0; _i < _ctx->_n; _i++) {
+			avlt_shard_delete(_ctx->_avlt_shard, _ctx->_keys[_i]);
+		}
+		break;
+	case BENCH_SHARD_BATCH:
+		for (_j = 0; _j < BENCH_BATCH; _j++) {
+			_values[_j] = NULL;
+		}
+		for (_i = 0; _i < _ctx->_n; _i += BENCH_BATCH) {
+			_j = (_ctx->_n - _i < BENCH_BATCH) ? _ctx->_n - _i :
+				BENCH_BATCH;
+			avlt_shard_insert_batch(_ctx->_avlt_shard,
+						_ctx->_keys + _i, _values, _j);
+		}
+		for (_i = 0; _i < _ctx->_n; _i += BENCH_BATCH) {
+			_j = (_ctx->_n - _i < BENCH_BATCH) ? _ctx->_n - _i :
+				BENCH_BATCH;
+			avlt_shard_search_batch(_ctx->_avlt_shard,
+						_ctx->_keys + _i, _values, _j);
+		}
+		for (_i = 0; _i < _ctx->_n; _i += BENCH_BATCH) {
+			_j = (_ctx->_n - _i < BENCH_BATCH) ? _ctx->_n - _i :
+				BENCH_BATCH;
+			avlt_shard_delete_batch(_ctx->_avlt_shard,
+						_ctx->_keys + _i, _j);
+		}
+		break;
+	}
+	timer_stop(&_ctx->_tp);
+	return NULL;
+}
+
+static void run(const char *_label, int _mode, avlt_shard_t *_avlt_shard,
+		uint *_keys, size_t _n, int _threads)
+{
+	pthread_mutex_t _lock = PTHREAD_MUTEX_INITIALIZER;
+	pthread_t _tids[_threads];
+	bench_ctx_t _ctx[_threads];
+	time_probe_t _wall;
+	char _name[64];
+	avlt_t _avlt;
+	int _t;
+
+	avlt_init_pool(&_avlt, 0);
+	for (_t = 0; _t < _threads; _t++) {
+		_ctx[_t]._mode = _mode;
+		_ctx[_t]._avlt = &_avlt;
+		_ctx[_t]._lock = &_lock;
+		_ctx[_t]._avlt_shard = _avlt_shard;
+		_ctx[_t]._keys = _keys + _t * _n;
+		_ctx[_t]._n = _n;
+	}
+	bench_probe_reset(&_wall);
+	timer_start(&_wall);
+	for (_t = 0; _t < _threads; _t++) {
+		pthread_create(&_tids[_t], NULL, worker, &_ctx[_t]);
+	}
+	for (_t = 0; _t < _threads; _t++) {
+		pthread_join(_tids[_t], NULL);
+	}
+	timer_stop(&_wall);
+	avlt_destroy_pool(&_avlt);
+
+	snprintf(_name, sizeof(_name), "%s threads %d", _label, _threads);
+	bench_report(_name, &_wall, 3 * _n * _threads);
+}
+
+int main(int argc, char **argv)
+{
+	size_t _n = bench_arg_size(argc, argv, 1, 100000);
+	size_t _num_shards = bench_arg_size(argc, argv, 2, 64);
+	int _max_threads = (int) bench_arg_size(argc, argv, 3, 64);
+	uint *_keys = bench_unique_keys(_n * _max_threads, 0x1234);
+	avlt_shard_t _avlt_shard;
+	int _t;
+
+	avlt_shard_init(&_avlt_shard, _num_shards);
+	for (_t = 1; _t <= _max_threads; _t *= 2) {
+		run("locked", BENCH_LOCKED, NULL, _keys, _n, _t);
+		run("shard", BENCH_SHARD, &_avlt_shard, _keys, _n, _t);
+		run("shard_batch", BENCH_SHARD_BATCH, &_avlt_shard, _keys, _n,
+		    _t);
+	}
+	avlt_shard_destroy(&_avlt_shard);
+	free(_keys);
+	return 0;
+}
@@ -0,0 +1,77 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_avlt_stats.c
+
+Tree shape and hot-path counters next to per-operation
+latencies.  Counters are only reported when everything is
+built with "make DEFS=-DAVLT_STATS" (after a make clean).
+
+usage: bench_avlt_stats [num_keys] [num_lookups]
+
+\**************************************************/
+
+#include "c_avlt.h"
+#include "bench_util.h"
+
+int main(int argc, char **argv)
+{
+	size_t _n = bench_arg_size(argc, argv, 1, 1000000);
+	size_t _lookups = bench_arg_size(argc, argv, 2, 1000000);
+	uint *_keys = bench_unique_keys(_n, 0x1234);
+	uint64_t _seed = 0x5678;
+	uintptr_t _sum = 0;
+	time_probe_t _tp;
+	avlt_stats_t _stats;
+	avlt_t _avlt;
+	size_t _i;
+
+	avlt_init_pool(&_avlt, 0);
+	bench_probe_reset(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		timer_start(&_tp);
+		avlt_insert(&_avlt, _keys[_i], NULL);
+		timer_stop(&_tp);
+	}
+	timer_gen_stats(&_tp);
+	fprintf(stdout, "== avlt_insert\n");
+	timer_print_stats(stdout, &_tp);
+	avlt_stats(&_avlt, &_stats);
+	avlt_stats_print(stdout, &_stats, &_tp);
+
+	avlt_stats_reset(&_avlt);
+	bench_probe_reset(&_tp);
+	for (_i = 0; _i < _lookups; _i++) {
+		uint _key = _keys[bench_rand(&_seed) % _n] + (_i & 1);
+		timer_start(&_tp);
+		_sum += (uintptr_t) avlt_search(&_avlt, _key);
+		timer_stop(&_tp);
+	}
+	timer_gen_stats(&_tp);
+	fprintf(stdout, "== avlt_search\n");
+	timer_print_stats(stdout, &_tp);
+	avlt_stats(&_avlt, &_stats);
+	avlt_stats_print(stdout, &_stats, &_tp);
+
+	avlt_stats_reset(&_avlt);
+	bench_probe_reset(&_tp);
+	for (_i = 0; _i < _n / 2; _i++) {
+		timer_start(&_tp);
+		avlt_delete(&_avlt, _keys[_i]);
+		timer_stop(&_tp);
+	}
+	timer_gen_stats(&_tp);
+	fprintf(stdout, "== avlt_delete\n");
+	timer_print_stats(stdout, &_tp);
+	avlt_stats(&_avlt, &_stats);
+	avlt_stats_print(stdout, &_stats, &_tp);
+
+	if (_sum != 0) {
+		fprintf(stderr, "ERROR: lookups returned unexpected values\n");
+		return 1;
+	}
+	avlt_destroy_pool(&_avlt);
+	free(_keys);
+	return 0;
+}
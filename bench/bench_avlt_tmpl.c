@@ -0,0 +1,100 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_avlt_tmpl.c
+
+The uint avlt_t against trees generated from c_avlt_tmpl.h
+for 32-bit, 64-bit and 16-byte keys.
+
+usage: bench_avlt_tmpl [num_keys] [num_lookups]
+
+\**************************************************/
+
+#include "c_avlt.h"
+#include "c_avlt_types.h"
+#include "bench_util.h"
+
+#define AVLT_TMPL_NAME avlt_u32
+#define AVLT_TMPL_KEY_T uint
+#include "c_avlt_tmpl.h"
+
+static avlt_b16_key_t b16_key(uint _key)
+{
+	avlt_b16_key_t _b16;
+	memset(&_b16, 0xA5, sizeof(_b16));
+	memcpy(_b16._bytes + 8, &_key, sizeof(_key));
+	return _b16;
+}
+
+// Runs insert/search/delete on any tree with the avlt_* shaped API.
+#define BENCH_TREE(_label, _prefix, _tree, _key_of)			\
+	do {								\
+		_sum = 0;						\
+		bench_probe_reset(&_tp);				\
+		timer_start(&_tp);					\
+		for (_i = 0; _i < _n; _i++) {				\
+			_prefix##_insert(_tree, _key_of(_keys[_i]),	\
+					 (void *) (uintptr_t) _keys[_i]); \
+		}							\
+		timer_stop(&_tp);					\
+		bench_report(_label " insert", &_tp, _n);		\
+		bench_probe_reset(&_tp);				\
+		timer_start(&_tp);					\
+		for (_i = 0; _i < _lookups; _i++) {			\
+			_sum += (uintptr_t) _prefix##_search(		\
+				_tree, _key_of(_probe[_i]));		\
+		}							\
+		timer_stop(&_tp);					\
+		bench_report(_label " search", &_tp, _lookups);	\
+		bench_probe_reset(&_tp);				\
+		timer_start(&_tp);					\
+		for (_i = 0; _i < _n; _i++) {				\
+			_prefix##_delete(_tree, _key_of(_keys[_i]));	\
+		}							\
+		timer_stop(&_tp);					\
+		bench_report(_label " delete", &_tp, _n);		\
+		if (_expect == 0) {					\
+			_expect = _sum;					\
+		} else if (_sum != _expect) {				\
+			fprintf(stderr, "ERROR: trees disagree\n");	\
+			return 1;					\
+		}							\
+	} while (0)
+
+#define AS_IS(_key) (_key)
+
+int main(int argc, char **argv)
+{
+	size_t _n = bench_arg_size(argc, argv, 1, 1000000);
+	size_t _lookups = bench_arg_size(argc, argv, 2, 2000000);
+	uint *_keys = bench_unique_keys(_n, 0x1234);
+	uint *_probe = (uint *) malloc(_lookups * sizeof(uint));
+	uint64_t _seed = 0x5678;
+	uintptr_t _sum = 0;
+	uintptr_t _expect = 0;
+	time_probe_t _tp;
+	avlt_t _avlt;
+	avlt_u32_t _avlt_u32;
+	avlt_u64_t _avlt_u64;
+	avlt_b16_t _avlt_b16;
+	size_t _i;
+
+	for (_i = 0; _i < _lookups; _i++) {
+		_probe[_i] = _keys[bench_rand(&_seed) % _n];
+	}
+
+	avlt_init(&_avlt);
+	avlt_u32_init(&_avlt_u32);
+	avlt_u64_init(&_avlt_u64);
+	avlt_b16_init(&_avlt_b16);
+
+	BENCH_TREE("avlt_t", avlt, &_avlt, AS_IS);
+	BENCH_TREE("avlt_u32_t", avlt_u32, &_avlt_u32, AS_IS);
+	BENCH_TREE("avlt_u64_t", avlt_u64, &_avlt_u64, AS_IS);
+	BENCH_TREE("avlt_b16_t", avlt_b16, &_avlt_b16, b16_key);
+
+	free(_probe);
+	free(_keys);
+	return 0;
+}
@@ -0,0 +1,85 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_avltc.c
+
+Memory footprint and lookup throughput of the compact
+index-based tree (avltc_t) against the pointer-based avlt_t.
+
+usage: bench_avltc [num_keys] [num_lookups]
+
+\**************************************************/
+
+#include "c_avlt.h"
+#include "c_avltc.h"
+#include "bench_util.h"
+
+int main(int argc, char **argv)
+{
+	size_t _n = bench_arg_size(argc, argv, 1, 4000000);
+	size_t _lookups = bench_arg_size(argc, argv, 2, 4000000);
+	uint *_keys = bench_unique_keys(_n, 0x1234);
+	uint *_probe = (uint *) malloc(_lookups * sizeof(uint));
+	uint64_t _seed = 0x5678;
+	uintptr_t _sum = 0;
+	time_probe_t _tp;
+	avlt_t _avlt;
+	avltc_t _avltc;
+	size_t _i;
+
+	for (_i = 0; _i < _lookups; _i++) {
+		_probe[_i] = _keys[bench_rand(&_seed) % _n];
+	}
+
+	avlt_init_pool(&_avlt, 0);
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		avlt_insert(&_avlt, _keys[_i], (void *) (uintptr_t) _keys[_i]);
+	}
+	timer_stop(&_tp);
+	bench_report("avlt insert", &_tp, _n);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _lookups; _i++) {
+		_sum += (uintptr_t) avlt_search(&_avlt, _probe[_i]);
+	}
+	timer_stop(&_tp);
+	bench_report("avlt search", &_tp, _lookups);
+	fprintf(stdout, "avlt bytes/entry %zu\n", sizeof(_avlt_node_t));
+	avlt_destroy_pool(&_avlt);
+
+	avltc_init(&_avltc);
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		avltc_insert(&_avltc, _keys[_i], (void *) (uintptr_t) _keys[_i]);
+	}
+	timer_stop(&_tp);
+	bench_report("avltc insert", &_tp, _n);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _lookups; _i++) {
+		_sum -= (uintptr_t) avltc_search(&_avltc, _probe[_i]);
+	}
+	timer_stop(&_tp);
+	bench_report("avltc search", &_tp, _lookups);
+	// The arena doubles, so report both the node size and what the
+	// arena actually holds per entry.
+	fprintf(stdout, "avltc bytes/entry %zu (arena %.1f)\n",
+		sizeof(_avltc_node_t),
+		(double) _avltc._capacity * sizeof(_avltc_node_t) /
+		(double) _avltc._size);
+	avltc_destroy(&_avltc);
+
+	if (_sum != 0) {
+		fprintf(stderr, "ERROR: avlt and avltc lookups disagree\n");
+		return 1;
+	}
+	free(_probe);
+	free(_keys);
+	return 0;
+}
@@ -0,0 +1,131 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_bdeque.c
+
+The linked-list dq_t against the block deque bdq_t: filling,
+iterating, indexing and draining a large queue.
+
+usage: bench_bdeque [num_items] [num_lookups]
+
+\**************************************************/
+
+#include "c_deque.h"
+#include "c_bdeque.h"
+#include "bench_util.h"
+
+int main(int argc, char **argv)
+{
+	size_t _n = bench_arg_size(argc, argv, 1, 4000000);
+	size_t _lookups = bench_arg_size(argc, argv, 2, 100000);
+	uint64_t _seed = 0x1234;
+	uintptr_t _sum = 0;
+	time_probe_t _tp;
+	dq_t _dq;
+	bdq_t _bdq;
+	dq_itr_t _dq_itr;
+	bdq_itr_t _bdq_itr;
+	size_t _i;
+
+	if (_n == 0) {
+		return 0;
+	}
+	dq_initialize(&_dq);
+	bdq_initialize(&_bdq);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		dq_push_back(&_dq, (void *) (uintptr_t) _i);
+	}
+	timer_stop(&_tp);
+	bench_report("dq_push_back", &_tp, _n);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		bdq_push_back(&_bdq, (void *) (uintptr_t) _i);
+	}
+	timer_stop(&_tp);
+	bench_report("bdq_push_back", &_tp, _n);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_dq_itr = dq_get_itr(&_dq); _dq_itr != NULL;
+	     _dq_itr = dq_itr_move_next(_dq_itr)) {
+		_sum += (uintptr_t) _dq_itr->_data;
+	}
+	timer_stop(&_tp);
+	bench_report("dq iterate", &_tp, _n);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_bdq_itr = bdq_get_itr(&_bdq); !bdq_itr_end(_bdq_itr);
+	     _bdq_itr = bdq_itr_move_next(_bdq_itr)) {
+		_sum -= (uintptr_t) bdq_itr_data(_bdq_itr);
+	}
+	timer_stop(&_tp);
+	bench_report("bdq iterate", &_tp, _n);
+
+	// dq_at walks the list, so it only runs a slice of the lookups.
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _lookups / 1000 + 1; _i++) {
+		_sum += (uintptr_t) dq_at(&_dq, bench_rand(&_seed) % _n);
+	}
+	timer_stop(&_tp);
+	bench_report("dq_at", &_tp, _lookups / 1000 + 1);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _lookups; _i++) {
+		_sum += (uintptr_t) bdq_at(&_bdq, bench_rand(&_seed) % _n);
+	}
+	timer_stop(&_tp);
+	bench_report("bdq_at", &_tp, _lookups);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		_sum += (uintptr_t) dq_pop_front(&_dq);
+	}
+	timer_stop(&_tp);
+	bench_report("dq_pop_front", &_tp, _n);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		_sum -= (uintptr_t) bdq_pop_front(&_bdq);
+	}
+	timer_stop(&_tp);
+	bench_report("bdq_pop_front", &_tp, _n);
+
+	// A short queue used as a FIFO, the common case for work queues.
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		dq_push_back(&_dq, (void *) (uintptr_t) _i);
+		if (dq_size(&_dq) > 64) {
+			dq_pop_front(&_dq);
+		}
+	}
+	timer_stop(&_tp);
+	bench_report("dq fifo(64)", &_tp, _n);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		bdq_push_back(&_bdq, (void *) (uintptr_t) _i);
+		if (bdq_size(&_bdq) > 64) {
+			bdq_pop_front(&_bdq);
+		}
+	}
+	timer_stop(&_tp);
+	bench_report("bdq fifo(64)", &_tp, _n);
+
+	fprintf(stdout, "checksum %lu\n", (unsigned long) _sum);
+	dq_clear(&_dq);
+	bdq_clear(&_bdq);
+	return 0;
+}
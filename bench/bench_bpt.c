@@ -0,0 +1,148 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_bpt.c
+
+avlt_t against bpt_t for insert, lookup, ordered scan and
+delete, with the tree growing from L1-resident to far past
+the last-level cache.
+
+usage: bench_bpt [max_keys] [num_lookups] [scan_len]
+
+\**************************************************/
+
+#include "c_avlt.h"
+#include "c_bpt.h"
+#include "bench_util.h"
+
+static int _scan_cb(uint _key, void *_value, void *_arg)
+{
+	*(uintptr_t *) _arg += (uintptr_t) _value - _key;
+	return 0;
+}
+
+static void _run(size_t _n, size_t _lookups, size_t _scan_len)
+{
+	uint *_keys = bench_unique_keys(_n, 0x1234 + _n);
+	uint *_probe = (uint *) malloc(_lookups * sizeof(uint));
+	size_t _scans = _lookups / _scan_len + 1;
+	uint64_t _seed = 0x5678;
+	uintptr_t _sum = 0;
+	char _name[64];
+	time_probe_t _tp;
+	avlt_t _avlt;
+	bpt_t _bpt;
+	size_t _i;
+
+	for (_i = 0; _i < _lookups; _i++) {
+		_probe[_i] = _keys[bench_rand(&_seed) % _n] + (_i & 1);
+	}
+	fprintf(stdout, "-- %zu keys, %.1f KB avlt, %.1f KB bpt leaves\n",
+		_n, (double) _n * sizeof(_avlt_node_t) / 1024,
+		(double) _n / (BPT_NODE_KEYS * 3 / 4) *
+		sizeof(_bpt_leaf_t) / 1024);
+
+	avlt_init_pool(&_avlt, 0);
+	snprintf(_name, sizeof(_name), "avlt_insert %zu", _n);
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		avlt_insert(&_avlt, _keys[_i], (void *) (uintptr_t) _keys[_i]);
+	}
+	timer_stop(&_tp);
+	bench_report(_name, &_tp, _n);
+
+	bpt_init(&_bpt);
+	snprintf(_name, sizeof(_name), "bpt_insert %zu", _n);
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		bpt_insert(&_bpt, _keys[_i], (void *) (uintptr_t) _keys[_i]);
+	}
+	timer_stop(&_tp);
+	bench_report(_name, &_tp, _n);
+
+	snprintf(_name, sizeof(_name), "avlt_search %zu", _n);
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _lookups; _i++) {
+		_sum += (uintptr_t) avlt_search(&_avlt, _probe[_i]);
+	}
+	timer_stop(&_tp);
+	bench_report(_name, &_tp, _lookups);
+
+	snprintf(_name, sizeof(_name), "bpt_search %zu", _n);
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _lookups; _i++) {
+		_sum -= (uintptr_t) bpt_search(&_bpt, _probe[_i]);
+	}
+	timer_stop(&_tp);
+	bench_report(_name, &_tp, _lookups);
+
+	// Scans report per entry visited.
+	snprintf(_name, sizeof(_name), "avlt_range %zu", _n);
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _scans; _i++) {
+		avlt_range(&_avlt, _probe[_i], _probe[_i] + 2 * _scan_len,
+			   _scan_cb, &_sum);
+	}
+	timer_stop(&_tp);
+	bench_report(_name, &_tp, _scans * _scan_len);
+
+	snprintf(_name, sizeof(_name), "bpt_range %zu", _n);
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _scans; _i++) {
+		bpt_range(&_bpt, _probe[_i], _probe[_i] + 2 * _scan_len,
+			  _scan_cb, &_sum);
+	}
+	timer_stop(&_tp);
+	bench_report(_name, &_tp, _scans * _scan_len);
+
+	snprintf(_name, sizeof(_name), "avlt_delete %zu", _n);
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		avlt_delete(&_avlt, _keys[_i]);
+	}
+	timer_stop(&_tp);
+	bench_report(_name, &_tp, _n);
+
+	snprintf(_name, sizeof(_name), "bpt_delete %zu", _n);
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		bpt_delete(&_bpt, _keys[_i]);
+	}
+	timer_stop(&_tp);
+	bench_report(_name, &_tp, _n);
+
+	if (_sum != 0 || _bpt._size != 0) {
+		fprintf(stderr, "ERROR: avlt and bpt disagree\n");
+		exit(1);
+	}
+	bpt_destroy(&_bpt);
+	avlt_destroy_pool(&_avlt);
+	free(_probe);
+	free(_keys);
+}
+
+int main(int argc, char **argv)
+{
+	size_t _max = bench_arg_size(argc, argv, 1, 1 << 22);
+	size_t _lookups = bench_arg_size(argc, argv, 2, 2000000);
+	size_t _scan_len = bench_arg_size(argc, argv, 3, 64);
+	size_t _n;
+
+	if (_scan_len == 0) {
+		_scan_len = 1;
+	}
+	// The smallest trees fit in L1, the largest take hundreds of MB.
+	for (_n = 1 << 10; _n <= _max; _n *= 4) {
+		_run(_n, _lookups, _scan_len);
+	}
+	return 0;
+}
@@ -0,0 +1,75 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_deque_batch.c
+
+A dispatcher moving batches between dq_t queues: item by item,
+with dq_push_back_n/dq_pop_front_n, and with dq_splice.
+
+usage: bench_deque_batch [num_batches] [batch_size]
+
+\**************************************************/
+
+#include "c_deque.h"
+#include "bench_util.h"
+
+int main(int argc, char **argv)
+{
+	size_t _batches = bench_arg_size(argc, argv, 1, 100000);
+	size_t _batch = bench_arg_size(argc, argv, 2, 64);
+	void **_buf = (void **) malloc((_batch + 1) * sizeof(void *));
+	uintptr_t _sum = 0;
+	time_probe_t _tp;
+	dq_t _in;
+	dq_t _out;
+	size_t _i;
+	size_t _j;
+
+	dq_initialize(&_in);
+	dq_initialize(&_out);
+	dq_enable_cache(&_out);
+	dq_share_cache(&_in, &_out);
+	for (_j = 0; _j < _batch; _j++) {
+		_buf[_j] = (void *) (uintptr_t) _j;
+	}
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _batches; _i++) {
+		for (_j = 0; _j < _batch; _j++) {
+			dq_push_back(&_in, _buf[_j]);
+		}
+		while (dq_size(&_in) > 0) {
+			dq_push_back(&_out, dq_pop_front(&_in));
+		}
+		while (dq_size(&_out) > 0) {
+			_sum += (uintptr_t) dq_pop_front(&_out);
+		}
+	}
+	timer_stop(&_tp);
+	bench_report("item by item", &_tp, _batches * _batch);
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _batches; _i++) {
+		dq_push_back_n(&_in, _buf, _batch);
+		dq_splice(&_out, &_in);
+		_j = dq_pop_front_n(&_out, _buf, _batch);
+		while (_j > 0) {
+			_sum -= (uintptr_t) _buf[--_j];
+		}
+	}
+	timer_stop(&_tp);
+	bench_report("push_back_n/splice/pop_front_n", &_tp,
+		     _batches * _batch);
+
+	if (_sum != 0) {
+		fprintf(stderr, "ERROR: batches lost items\n");
+		return 1;
+	}
+	dq_clear(&_out);
+	dq_clear(&_in);
+	free(_buf);
+	return 0;
+}
@@ -0,0 +1,64 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_deque_index.c
+
+Random positional dq_insert_at/dq_at/dq_erase_at on a plain
+dq_t and on one with dq_enable_index(), for growing sizes.
+
+usage: bench_deque_index [max_items] [num_ops]
+
+\**************************************************/
+
+#include "c_deque.h"
+#include "bench_util.h"
+
+static uintptr_t _run(size_t _n, size_t _ops, bool _indexed)
+{
+	uint64_t _seed = 0x1234 + _n;
+	uintptr_t _sum = 0;
+	time_probe_t _tp;
+	char _name[64];
+	dq_t _dq;
+	size_t _i;
+
+	dq_initialize(&_dq);
+	if (_indexed) {
+		dq_enable_index(&_dq);
+	}
+	for (_i = 0; _i < _n; _i++) {
+		dq_push_back(&_dq, (void *) (uintptr_t) _i);
+	}
+
+	snprintf(_name, sizeof(_name), "%s %zu items",
+		 _indexed ? "indexed" : "plain", _n);
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _ops; _i++) {
+		size_t _at = bench_rand(&_seed) % (_n + 1);
+		dq_insert_at(&_dq, _at, (void *) (uintptr_t) _i);
+		_sum += (uintptr_t) dq_at(&_dq, bench_rand(&_seed) % (_n + 1));
+		_sum += (uintptr_t) dq_erase_at(&_dq,
+						bench_rand(&_seed) % (_n + 1));
+	}
+	timer_stop(&_tp);
+	bench_report(_name, &_tp, _ops);
+	dq_clear(&_dq);
+	return _sum;
+}
+
+int main(int argc, char **argv)
+{
+	size_t _max = bench_arg_size(argc, argv, 1, 1 << 20);
+	size_t _ops = bench_arg_size(argc, argv, 2, 2000);
+	uintptr_t _sum = 0;
+	size_t _n;
+
+	for (_n = 1024; _n <= _max; _n *= 4) {
+		_sum += _run(_n, _ops, false);
+		_sum -= _run(_n, _ops, true);
+	}
+	fprintf(stdout, "checksum %lu\n", (unsigned long) _sum);
+	return 0;
+}
@@ -0,0 +1,228 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_mpmcq.c
+
+Fan-in/fan-out through mpmcq_t, item by item and in batches,
+against a mutex-guarded dq_t, with 1, 2, 4, ... producers and
+as many consumers.  Each item carries the time it was pushed,
+so consumers also collect handoff latencies; every 16th is
+kept for the median and p99.
+
+usage: bench_mpmcq [items] [max_threads] [capacity] [batch]
+
+\**************************************************/
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "c_deque.h"
+#include "c_mpmcq.h"
+#include "bench_util.h"
+
+#define _SAMPLE_EVERY (16)
+
+typedef enum { _MPMCQ, _MPMCQ_BATCH, _MUTEX_DQ } _mode_t;
+
+typedef struct bench_shared {
+	_mode_t _mode;
+	mpmcq_t _q;
+	dq_t _dq;
+	pthread_mutex_t _lock;
+	size_t _batch;
+	size_t _per_producer;
+	size_t _remaining;	// items not yet consumed
+} bench_shared_t;
+
+typedef struct bench_ctx {
+	bench_shared_t *_shared;
+	uint64_t *_samples;
+	size_t _num_samples;
+	size_t _max_samples;
+} bench_ctx_t;
+
+static inline uint64_t _now_ns(void)
+{
+	struct timespec _ts;
+	clock_gettime(CLOCK_MONOTONIC, &_ts);
+	return (uint64_t) _ts.tv_sec * 1000000000ULL + _ts.tv_nsec;
+}
+
+static void *producer(void *_arg)
+{
+	bench_ctx_t *_ctx = (bench_ctx_t *) _arg;
+	bench_shared_t *_sh = _ctx->_shared;
+	void **_buf = (void **) malloc(_sh->_batch * sizeof(void *));
+	size_t _i = 0;
+	size_t _j;
+
+	while (_i < _sh->_per_producer) {
+		size_t _cnt = 1;
+		if (_sh->_mode == _MPMCQ_BATCH) {
+			_cnt = _sh->_batch;
+			if (_cnt > _sh->_per_producer - _i) {
+				_cnt = _sh->_per_producer - _i;
+			}
+		}
+		for (_j = 0; _j < _cnt; _j++) {
+			_buf[_j] = (void *) (uintptr_t) _now_ns();
+		}
+		if (_sh->_mode == _MPMCQ) {
+			mpmcq_push(&_sh->_q, _buf[0]);
+		} else if (_sh->_mode == _MPMCQ_BATCH) {
+			_j = 0;
+			while (_j < _cnt) {
+				size_t _done = mpmcq_try_push_n(&_sh->_q, _buf + _j,
+								_cnt - _j);
+				if (_done == 0) {
+					sched_yield();
+				}
+				_j += _done;
+			}
+		} else {
+			pthread_mutex_lock(&_sh->_lock);
+			dq_push_back(&_sh->_dq, _buf[0]);
+			pthread_mutex_unlock(&_sh->_lock);
+		}
+		_i += _cnt;
+	}
+	free(_buf);
+	return NULL;
+}
+
+static void *consumer(void *_arg)
+{
+	bench_ctx_t *_ctx = (bench_ctx_t *) _arg;
+	bench_shared_t *_sh = _ctx->_shared;
+	void **_buf = (void **) malloc(_sh->_batch * sizeof(void *));
+	size_t _seen = 0;
+
+	while (__atomic_load_n(&_sh->_remaining, __ATOMIC_RELAXED) > 0) {
+		size_t _cnt = 0;
+		size_t _j;
+		if (_sh->_mode == _MUTEX_DQ) {
+			pthread_mutex_lock(&_sh->_lock);
+			if (dq_size(&_sh->_dq) > 0) {
+				_buf[0] = dq_pop_front(&_sh->_dq);
+				_cnt = 1;
+			}
+			pthread_mutex_unlock(&_sh->_lock);
+		} else {
+			_cnt = mpmcq_try_pop_n(&_sh->_q, _buf,
+					       (_sh->_mode == _MPMCQ_BATCH) ?
+					       _sh->_batch : 1);
+		}
+		if (_cnt == 0) {
+			sched_yield();
+			continue;
+		}
+		__atomic_sub_fetch(&_sh->_remaining, _cnt, __ATOMIC_RELAXED);
+		for (_j = 0; _j < _cnt; _j++) {
+			if (_seen++ % _SAMPLE_EVERY == 0 &&
+			    _ctx->_num_samples < _ctx->_max_samples) {
+				_ctx->_samples[_ctx->_num_samples++] =
+					_now_ns() - (uint64_t) (uintptr_t) _buf[_j];
+			}
+		}
+	}
+	free(_buf);
+	return NULL;
+}
+
+static int _cmp_u64(const void *_a, const void *_b)
+{
+	uint64_t _x = *(const uint64_t *) _a;
+	uint64_t _y = *(const uint64_t *) _b;
+	return (_x > _y) - (_x < _y);
+}
+
+static void _run(bench_shared_t *_sh, size_t _threads, size_t _items,
+		 const char *_label)
+{
+	bench_ctx_t *_ctx = (bench_ctx_t *) calloc(2 * _threads,
+						   sizeof(bench_ctx_t));
+	pthread_t *_tid = (pthread_t *) malloc(2 * _threads *
+					       sizeof(pthread_t));
+	size_t _max_samples = _items / _SAMPLE_EVERY / _threads + 16;
+	uint64_t *_all;
+	size_t _total = 0;
+	time_probe_t _tp;
+	char _name[64];
+	size_t _i;
+
+	_sh->_per_producer = _items / _threads;
+	_sh->_remaining = _sh->_per_producer * _threads;
+	for (_i = 0; _i < 2 * _threads; _i++) {
+		_ctx[_i]._shared = _sh;
+		if (_i >= _threads) {
+			_ctx[_i]._max_samples = _max_samples;
+			_ctx[_i]._samples = (uint64_t *)
+				malloc(_max_samples * sizeof(uint64_t));
+		}
+	}
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < 2 * _threads; _i++) {
+		pthread_create(&_tid[_i], NULL,
+			       (_i < _threads) ? producer : consumer, &_ctx[_i]);
+	}
+	for (_i = 0; _i < 2 * _threads; _i++) {
+		pthread_join(_tid[_i], NULL);
+	}
+	timer_stop(&_tp);
+
+	snprintf(_name, sizeof(_name), "%s %zup/%zuc", _label, _threads,
+		 _threads);
+	bench_report(_name, &_tp, _sh->_per_producer * _threads);
+
+	_all = (uint64_t *) malloc(_threads * _max_samples * sizeof(uint64_t));
+	for (_i = _threads; _i < 2 * _threads; _i++) {
+		memcpy(&_all[_total], _ctx[_i]._samples,
+		       _ctx[_i]._num_samples * sizeof(uint64_t));
+		_total += _ctx[_i]._num_samples;
+		free(_ctx[_i]._samples);
+	}
+	if (_total > 0) {
+		qsort(_all, _total, sizeof(uint64_t), _cmp_u64);
+		fprintf(stdout, "%-32s handoff p50 %8.1f us p99 %8.1f us\n", "",
+			_all[_total / 2] / 1000.0,
+			_all[_total * 99 / 100] / 1000.0);
+	}
+	free(_all);
+	free(_tid);
+	free(_ctx);
+}
+
+int main(int argc, char **argv)
+{
+	size_t _items = bench_arg_size(argc, argv, 1, 2000000);
+	size_t _max_threads = bench_arg_size(argc, argv, 2, 64);
+	size_t _cap = bench_arg_size(argc, argv, 3, 4096);
+	size_t _batch = bench_arg_size(argc, argv, 4, 16);
+	bench_shared_t _sh;
+	size_t _threads;
+
+	memset(&_sh, 0, sizeof(_sh));
+	mpmcq_init(&_sh._q, _cap);
+	dq_initialize(&_sh._dq);
+	pthread_mutex_init(&_sh._lock, NULL);
+	_sh._batch = (_batch > 0) ? _batch : 1;
+
+	// _max_threads counts producers and consumers together.
+	for (_threads = 1; 2 * _threads <= _max_threads; _threads *= 2) {
+		_sh._mode = _MPMCQ;
+		_run(&_sh, _threads, _items, "mpmcq");
+		_sh._mode = _MPMCQ_BATCH;
+		_run(&_sh, _threads, _items, "mpmcq batch");
+		_sh._mode = _MUTEX_DQ;
+		_run(&_sh, _threads, _items, "mutex + dq_t");
+	}
+
+	pthread_mutex_destroy(&_sh._lock);
+	dq_clear(&_sh._dq);
+	mpmcq_destroy(&_sh._q);
+	return 0;
+}
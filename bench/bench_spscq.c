@@ -0,0 +1,229 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_spscq.c
+
+Two threads passing items through spscq_t, one at a time
+and in batches, against a mutex-guarded dq_t.  Latency is
+measured as ping-pong round trips through a pair of rings.
+
+usage: bench_spscq [num_items] [capacity] [batch] [round_trips]
+
+\**************************************************/
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "c_deque.h"
+#include "c_spscq.h"
+#include "bench_util.h"
+
+typedef struct bench_ctx {
+	spscq_t *_q;
+	spscq_t *_back;		// ping-pong reply ring
+	dq_t *_dq;		// used with _lock when _q is NULL
+	pthread_mutex_t *_lock;
+	size_t _n;
+	size_t _batch;
+	uintptr_t _sum;
+} bench_ctx_t;
+
+// Spins a while on a full or empty ring, then yields so that the two
+// threads still make progress when they share a core.
+static inline void _wait(size_t *_spins)
+{
+	if (++*_spins % 256 == 0) {
+		sched_yield();
+	}
+}
+
+static void *consumer(void *_arg)
+{
+	bench_ctx_t *_ctx = (bench_ctx_t *) _arg;
+	void **_buf = (void **) malloc(_ctx->_batch * sizeof(void *));
+	size_t _got = 0;
+	size_t _spins = 0;
+	void *_item;
+
+	while (_got < _ctx->_n) {
+		if (_ctx->_q == NULL) {
+			pthread_mutex_lock(_ctx->_lock);
+			while (dq_size(_ctx->_dq) > 0) {
+				_ctx->_sum += (uintptr_t) dq_pop_front(_ctx->_dq);
+				_got++;
+			}
+			pthread_mutex_unlock(_ctx->_lock);
+			_wait(&_spins);
+		} else if (_ctx->_batch > 1) {
+			size_t _i = spscq_pop_n(_ctx->_q, _buf, _ctx->_batch);
+			if (_i == 0) {
+				_wait(&_spins);
+			}
+			_got += _i;
+			while (_i > 0) {
+				_ctx->_sum += (uintptr_t) _buf[--_i];
+			}
+		} else if (spscq_pop(_ctx->_q, &_item)) {
+			_ctx->_sum += (uintptr_t) _item;
+			_got++;
+		} else {
+			_wait(&_spins);
+		}
+	}
+	free(_buf);
+	return NULL;
+}
+
+static void _producer(bench_ctx_t *_ctx, const char *_name)
+{
+	void **_buf = (void **) malloc(_ctx->_batch * sizeof(void *));
+	uintptr_t _expect;
+	time_probe_t _tp;
+	pthread_t _thread;
+	size_t _spins = 0;
+	size_t _i = 0;
+
+	_ctx->_sum = 0;
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	pthread_create(&_thread, NULL, consumer, _ctx);
+	while (_i < _ctx->_n) {
+		if (_ctx->_q == NULL) {
+			pthread_mutex_lock(_ctx->_lock);
+			dq_push_back(_ctx->_dq, (void *) (uintptr_t) (_i + 1));
+			pthread_mutex_unlock(_ctx->_lock);
+			_i++;
+		} else if (_ctx->_batch > 1) {
+			size_t _j;
+			size_t _cnt = _ctx->_batch;
+			if (_cnt > _ctx->_n - _i) {
+				_cnt = _ctx->_n - _i;
+			}
+			for (_j = 0; _j < _cnt; _j++) {
+				_buf[_j] = (void *) (uintptr_t) (_i + _j + 1);
+			}
+			_j = 0;
+			while (_j < _cnt) {
+				_j += spscq_push_n(_ctx->_q, _buf + _j, _cnt - _j);
+				if (_j < _cnt) {
+					_wait(&_spins);
+				}
+			}
+			_i += _cnt;
+		} else if (spscq_push(_ctx->_q, (void *) (uintptr_t) (_i + 1))) {
+			_i++;
+		} else {
+			_wait(&_spins);
+		}
+	}
+	pthread_join(_thread, NULL);
+	timer_stop(&_tp);
+	bench_report(_name, &_tp, _ctx->_n);
+
+	_expect = (uintptr_t) _ctx->_n * (_ctx->_n + 1) / 2;
+	if (_ctx->_sum != _expect) {
+		fprintf(stderr, "ERROR: %s lost items\n", _name);
+		exit(1);
+	}
+	free(_buf);
+}
+
+static void *echo(void *_arg)
+{
+	bench_ctx_t *_ctx = (bench_ctx_t *) _arg;
+	size_t _spins = 0;
+	void *_item;
+	size_t _i;
+
+	for (_i = 0; _i < _ctx->_n; _i++) {
+		while (!spscq_pop(_ctx->_q, &_item)) {
+			_wait(&_spins);
+		}
+		while (!spscq_push(_ctx->_back, _item)) {
+			_wait(&_spins);
+		}
+	}
+	return NULL;
+}
+
+static void _ping_pong(size_t _trips)
+{
+	spscq_t _ping;
+	spscq_t _pong;
+	bench_ctx_t _ctx;
+	time_probe_t _tp;
+	pthread_t _thread;
+	size_t _spins = 0;
+	void *_item;
+	size_t _i;
+
+	spscq_init(&_ping, 64);
+	spscq_init(&_pong, 64);
+	memset(&_ctx, 0, sizeof(_ctx));
+	_ctx._q = &_ping;
+	_ctx._back = &_pong;
+	_ctx._n = _trips;
+	pthread_create(&_thread, NULL, echo, &_ctx);
+
+	bench_probe_reset(&_tp);
+	_tp.min_nano_lapse = INT64_MAX;
+	for (_i = 0; _i < _trips; _i++) {
+		timer_start(&_tp);
+		while (!spscq_push(&_ping, (void *) (uintptr_t) _i)) {
+			_wait(&_spins);
+		}
+		while (!spscq_pop(&_pong, &_item)) {
+			_wait(&_spins);
+		}
+		timer_stop(&_tp);
+	}
+	pthread_join(_thread, NULL);
+	timer_gen_stats(&_tp);
+	fprintf(stdout, "spscq round trip (includes two clock reads)\n");
+	timer_print_stats(stdout, &_tp);
+
+	spscq_destroy(&_pong);
+	spscq_destroy(&_ping);
+}
+
+int main(int argc, char **argv)
+{
+	size_t _n = bench_arg_size(argc, argv, 1, 20000000);
+	size_t _cap = bench_arg_size(argc, argv, 2, 4096);
+	size_t _batch = bench_arg_size(argc, argv, 3, 32);
+	size_t _trips = bench_arg_size(argc, argv, 4, 200000);
+	pthread_mutex_t _lock = PTHREAD_MUTEX_INITIALIZER;
+	bench_ctx_t _ctx;
+	spscq_t _q;
+	dq_t _dq;
+	char _name[64];
+
+	if (_batch == 0) {
+		_batch = 1;
+	}
+	spscq_init(&_q, _cap);
+	memset(&_ctx, 0, sizeof(_ctx));
+	_ctx._q = &_q;
+	_ctx._n = _n;
+	_ctx._batch = 1;
+	_producer(&_ctx, "spscq push/pop");
+
+	_ctx._batch = _batch;
+	snprintf(_name, sizeof(_name), "spscq push_n/pop_n (%zu)", _batch);
+	_producer(&_ctx, _name);
+
+	// The mutex baseline moves a tenth of the items to keep runs short.
+	dq_initialize(&_dq);
+	_ctx._q = NULL;
+	_ctx._dq = &_dq;
+	_ctx._lock = &_lock;
+	_ctx._n = _n / 10;
+	_ctx._batch = 1;
+	_producer(&_ctx, "mutex + dq_t");
+	dq_clear(&_dq);
+
+	_ping_pong(_trips);
+	spscq_destroy(&_q);
+	return 0;
+}
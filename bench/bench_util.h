@@ -0,0 +1,78 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_util.h
+
+Small helpers shared by the benchmarks.
+
+\**************************************************/
+
+#ifndef __BENCH_UTIL_H__
+#define __BENCH_UTIL_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "c_timer.h"
+
+// xorshift64*, good enough to scatter keys without touching libc state.
+static inline uint64_t bench_rand(uint64_t *_state)
+{
+	uint64_t _x = *_state;
+	_x ^= _x >> 12;
+	_x ^= _x << 25;
+	_x ^= _x >> 27;
+	*_state = _x;
+	return _x * 0x2545F4914F6CDD1DULL;
+}
+
+// Fisher-Yates shuffle of 0.._n-1 scaled apart so keys are unique.
+static inline uint *bench_unique_keys(size_t _n, uint64_t _seed)
+{
+	size_t _i;
+	uint *_keys = (uint *) malloc(_n * sizeof(uint));
+	if (_keys == NULL) {
+		fprintf(stderr, "ERROR: bench key allocation failed\n");
+		exit(EXIT_FAILURE);
+	}
+	for (_i = 0; _i < _n; _i++) {
+		_keys[_i] = (uint) (_i * 2 + 1);
+	}
+	for (_i = _n; _i > 1; _i--) {
+		size_t _j = bench_rand(&_seed) % _i;
+		uint _tmp = _keys[_i - 1];
+		_keys[_i - 1] = _keys[_j];
+		_keys[_j] = _tmp;
+	}
+	return _keys;
+}
+
+static inline void bench_probe_reset(time_probe_t *_tp)
+{
+	memset(_tp, 0, sizeof(*_tp));
+}
+
+// One probe lapse covers _ops operations; report ops/sec and ns/op.
+static inline void bench_report(const char *_name, time_probe_t *_tp,
+				size_t _ops)
+{
+	double _sec = (double) _tp->sum_nano_lapse / 1000000000.0;
+	fprintf(stdout, "%-32s %12zu ops %10.3f Mops/s %8.1f ns/op\n",
+		_name, _ops, _sec > 0 ? (double) _ops / _sec / 1000000.0 : 0,
+		_ops > 0 ? (double) _tp->sum_nano_lapse / (double) _ops : 0);
+	fflush(stdout);
+}
+
+static inline size_t bench_arg_size(int _argc, char **_argv, int _idx,
+				    size_t _def)
+{
+	if (_argc > _idx) {
+		return (size_t) strtoull(_argv[_idx], NULL, 10);
+	}
+	return _def;
+}
+
+#endif // end of #ifndef __BENCH_UTIL_H__
@@ -0,0 +1,161 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+bench_wsp.c
+
+Summing an array with the work-stealing pool, by recursive
+splitting (tasks spawn tasks on their worker's deque) and by
+submitting every leaf chunk through the shared queue, for 1,
+2, 4, ... workers.
+
+usage: bench_wsp [num_items] [grain] [max_workers]
+
+\**************************************************/
+
+#include "c_wsp.h"
+#include "bench_util.h"
+
+// Per-worker partial sums, each on its own cache line.
+#define _PAD (8)
+
+typedef struct bench_job {
+	wsp_t *_pool;
+	const uint64_t *_items;
+	size_t _lo;
+	size_t _hi;
+	size_t _grain;
+	uint64_t *_partial;
+} bench_job_t;
+
+static void _sum_leaf(bench_job_t *_job)
+{
+	uint64_t _sum = 0;
+	size_t _i;
+	for (_i = _job->_lo; _i < _job->_hi; _i++) {
+		_sum += _job->_items[_i];
+	}
+	_job->_partial[wsp_worker_id(_job->_pool) * _PAD] += _sum;
+}
+
+// Hands the upper half to the pool and keeps splitting the lower half.
+static void split_task(void *_arg)
+{
+	bench_job_t *_job = (bench_job_t *) _arg;
+
+	while (_job->_hi - _job->_lo > _job->_grain) {
+		size_t _mid = _job->_lo + (_job->_hi - _job->_lo) / 2;
+		bench_job_t *_right = (bench_job_t *) malloc(sizeof(bench_job_t));
+		*_right = *_job;
+		_right->_lo = _mid;
+		_job->_hi = _mid;
+		wsp_submit(_job->_pool, split_task, _right);
+	}
+	_sum_leaf(_job);
+	free(_job);
+}
+
+static void leaf_task(void *_arg)
+{
+	_sum_leaf((bench_job_t *) _arg);
+	free(_arg);
+}
+
+static uint64_t _collect(uint64_t *_partial, size_t _workers)
+{
+	uint64_t _sum = 0;
+	size_t _i;
+	for (_i = 0; _i <= _workers; _i++) {
+		_sum += _partial[_i * _PAD];
+		_partial[_i * _PAD] = 0;
+	}
+	return _sum;
+}
+
+int main(int argc, char **argv)
+{
+	size_t _n = bench_arg_size(argc, argv, 1, 50000000);
+	size_t _grain = bench_arg_size(argc, argv, 2, 16384);
+	size_t _max_workers = bench_arg_size(argc, argv, 3, 8);
+	uint64_t *_items = (uint64_t *) malloc(_n * sizeof(uint64_t));
+	uint64_t *_partial = (uint64_t *)
+		calloc((_max_workers + 1) * _PAD, sizeof(uint64_t));
+	uint64_t _seed = 0x1234;
+	uint64_t _expect = 0;
+	size_t _leaves = (_n + _grain - 1) / _grain;
+	size_t _workers;
+	size_t _i;
+	char _name[64];
+	time_probe_t _tp;
+
+	if (_grain == 0) {
+		return 1;
+	}
+	for (_i = 0; _i < _n; _i++) {
+		_items[_i] = bench_rand(&_seed) & 0xffff;
+	}
+
+	bench_probe_reset(&_tp);
+	timer_start(&_tp);
+	for (_i = 0; _i < _n; _i++) {
+		_expect += _items[_i];
+	}
+	timer_stop(&_tp);
+	bench_report("sequential sum", &_tp, _n);
+
+	for (_workers = 1; _workers <= _max_workers; _workers *= 2) {
+		wsp_t _pool;
+		bench_job_t *_job;
+
+		wsp_init(&_pool, _workers);
+
+		snprintf(_name, sizeof(_name), "split tasks %zu workers",
+			 _workers);
+		bench_probe_reset(&_tp);
+		timer_start(&_tp);
+		_job = (bench_job_t *) malloc(sizeof(bench_job_t));
+		_job->_pool = &_pool;
+		_job->_items = _items;
+		_job->_lo = 0;
+		_job->_hi = _n;
+		_job->_grain = _grain;
+		_job->_partial = _partial;
+		wsp_submit(&_pool, split_task, _job);
+		wsp_wait(&_pool);
+		timer_stop(&_tp);
+		bench_report(_name, &_tp, _n);
+		if (_collect(_partial, _workers) != _expect) {
+			fprintf(stderr, "ERROR: split sum is wrong\n");
+			return 1;
+		}
+
+		snprintf(_name, sizeof(_name), "shared queue %zu workers",
+			 _workers);
+		bench_probe_reset(&_tp);
+		timer_start(&_tp);
+		for (_i = 0; _i < _leaves; _i++) {
+			_job = (bench_job_t *) malloc(sizeof(bench_job_t));
+			_job->_pool = &_pool;
+			_job->_items = _items;
+			_job->_lo = _i * _grain;
+			_job->_hi = (_job->_lo + _grain < _n) ?
+				_job->_lo + _grain : _n;
+			_job->_grain = _grain;
+			_job->_partial = _partial;
+			wsp_submit(&_pool, leaf_task, _job);
+		}
+		wsp_wait(&_pool);
+		timer_stop(&_tp);
+		bench_report(_name, &_tp, _n);
+		if (_collect(_partial, _workers) != _expect) {
+			fprintf(stderr, "ERROR: shared queue sum is wrong\n");
+			return 1;
+		}
+
+		wsp_destroy(&_pool);
+	}
+
+	free(_partial);
+	free(_items);
+	return 0;
+}
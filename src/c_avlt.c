@@ -11,24 +11,66 @@ C-based AVLTree implementation.
 #include "c_avlt.h"
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 
 
-static inline _avlt_node_t * _create_new_node()
+static _avlt_node_t * _pool_alloc(_avlt_pool_t *_pool)
 {
-	_avlt_node_t *_node = (_avlt_node_t *) malloc(sizeof(_avlt_node_t));
+	_avlt_node_t *_node = _pool->_free_list;
+	if (_node != NULL) {
+		_pool->_free_list = _node->_parent;
+		return _node;
+	}
+	if (_pool->_chunks == NULL ||
+	    _pool->_chunk_used == _pool->_chunk_nodes) {
+		_avlt_pool_chunk_t *_chunk = (_avlt_pool_chunk_t *)
+			malloc(sizeof(_avlt_pool_chunk_t) +
+			       _pool->_chunk_nodes * sizeof(_avlt_node_t));
+		assert(_chunk != NULL);
+		_chunk->_next = _pool->_chunks;
+		_pool->_chunks = _chunk;
+		_pool->_chunk_used = 0;
+	}
+	return &_pool->_chunks->_nodes[_pool->_chunk_used++];
+}
+
+static inline _avlt_node_t * _create_new_node(avlt_t *_avlt)
+{
+	_avlt_node_t *_node;
+	if (_avlt->_pool != NULL) {
+		_node = _pool_alloc(_avlt->_pool);
+	} else {
+		_node = (_avlt_node_t *) malloc(sizeof(_avlt_node_t));
+	}
 	assert(_node != NULL);
+	_AVLT_STAT_ADD(_avlt, _allocs, 1);
 	_node->_key = _INIT_VAL;
 	_node->_value = NULL;
 	_node->_balance = 0;
+	_node->_count = 1;
 	_node->_parent = NULL;
 	_node->_left_child = NULL;
 	_node->_right_child = NULL;
 	return _node;
 }
 
+static inline void _free_node(avlt_t *_avlt, _avlt_node_t *_node)
+{
+	_AVLT_STAT_ADD(_avlt, _frees, 1);
+	if (_avlt->_pool != NULL) {
+		_node->_parent = _avlt->_pool->_free_list;
+		_avlt->_pool->_free_list = _node;
+	} else {
+		free(_node);
+	}
+}
+
+static size_t _free_subtree(avlt_t *_avlt, _avlt_node_t *_node);
+
 static inline int compare(uint _node_key, uint _input_key)
 {
 	if (_node_key > _input_key) {
@@ -40,12 +82,112 @@ static inline int compare(uint _node_key, uint _input_key)
 	}
 }
 
+#ifdef AVLT_STATS
+static void _stats_add(_avlt_counters_t *_dst, const _avlt_counters_t *_src)
+{
+	int _i;
+	_dst->_descents += _src->_descents;
+	_dst->_compares += _src->_compares;
+	for (_i = _RR; _i <= _LR; _i++) {
+		_dst->_rotations[_i] += _src->_rotations[_i];
+	}
+	_dst->_rebalances += _src->_rebalances;
+	_dst->_rebalance_levels += _src->_rebalance_levels;
+	if (_dst->_max_rebalance_levels < _src->_max_rebalance_levels) {
+		_dst->_max_rebalance_levels = _src->_max_rebalance_levels;
+	}
+	_dst->_allocs += _src->_allocs;
+	_dst->_frees += _src->_frees;
+}
+#endif
+
+// Detached subtrees are rebalanced through a scratch copy of the tree.
+// The copy counts from zero and its counts are added back afterwards.
+static inline void _stats_tmp_begin(avlt_t *_tmp)
+{
+#ifdef AVLT_STATS
+	memset(&_tmp->_counters, 0, sizeof(_tmp->_counters));
+#endif
+}
+
+static inline void _stats_tmp_end(avlt_t *_avlt, avlt_t *_tmp)
+{
+#ifdef AVLT_STATS
+	_stats_add(&_avlt->_counters, &_tmp->_counters);
+#endif
+}
+
+static inline void _stats_rebalance(avlt_t *_avlt, uint64_t _levels)
+{
+#ifdef AVLT_STATS
+	_avlt->_counters._rebalances++;
+	_avlt->_counters._rebalance_levels += _levels;
+	if (_avlt->_counters._max_rebalance_levels < _levels) {
+		_avlt->_counters._max_rebalance_levels = _levels;
+	}
+#endif
+}
+
 static inline bool _is_leaf(_avlt_node_t * _node)
 {
 	return (_node->_left_child == NULL && _node->_right_child == NULL);
 }
 
 
+static inline uint _count(_avlt_node_t *_node)
+{
+	return (_node != NULL) ? _node->_count : 0;
+}
+
+// Recomputes _count of _node from its children.  Callers make sure the
+// children are up to date first.
+static inline void _update_count(avlt_t *_avlt, _avlt_node_t *_node)
+{
+	if (_avlt->_flags & AVLT_ORDER_STAT) {
+		_node->_count = 1 + _count(_node->_left_child) +
+			_count(_node->_right_child);
+	}
+}
+
+// Adds _delta to _count of _node and all of its ancestors.
+static inline void _add_count_to_root(avlt_t *_avlt, _avlt_node_t *_node,
+				      int _delta)
+{
+	if (_avlt->_flags & AVLT_ORDER_STAT) {
+		while (_node != NULL) {
+			_node->_count += _delta;
+			_node = _node->_parent;
+		}
+	}
+}
+
+// Post-order walk through the parent pointers: children always come
+// before their parent, and a node is not looked at again once the walk
+// has moved past it.
+static inline _avlt_node_t * _first_postorder(_avlt_node_t *_node)
+{
+	while (_node != NULL) {
+		if (_node->_left_child != NULL) {
+			_node = _node->_left_child;
+		} else if (_node->_right_child != NULL) {
+			_node = _node->_right_child;
+		} else {
+			break;
+		}
+	}
+	return _node;
+}
+
+static inline _avlt_node_t * _next_postorder(_avlt_node_t *_node)
+{
+	_avlt_node_t *_parent = _node->_parent;
+	if (_parent != NULL && _parent->_left_child == _node &&
+	    _parent->_right_child != NULL) {
+		return _first_postorder(_parent->_right_child);
+	}
+	return _parent;
+}
+
 static inline _avlt_node_t * _get_max_of_left_subtree(_avlt_node_t *_node)
 {
 	_node = _node->_left_child;
@@ -62,7 +204,7 @@ static inline _avlt_node_t * _get_min_of_right_subtree(_avlt_node_t *_node)
 	_node = _node->_right_child;
 	if (_node != NULL) {
 		while (_node->_left_child != NULL) {
-			_node = _node->_right_child;
+			_node = _node->_left_child;
 		}
 	}
 	return _node;
@@ -176,6 +318,8 @@ static inline void _rr_rotation(avlt_t *_avlt, _avlt_node_t *_top,
 				_avlt_node_t *_middle)
 {
 	_avlt_node_t *_parent = _top->_parent;
+
+	_AVLT_STAT_ADD(_avlt, _rotations[_RR], 1);
 	_top->_left_child = _middle->_right_child;
 	if (_top->_left_child != NULL) {
 		_top->_left_child->_parent = _top;
@@ -195,12 +339,16 @@ static inline void _rr_rotation(avlt_t *_avlt, _avlt_node_t *_top,
 		_avlt->_root = _middle;
 		_middle->_parent = NULL;
 	}
+	_update_count(_avlt, _top);
+	_update_count(_avlt, _middle);
 }
 
 static inline void _lr_rotation(avlt_t *_avlt, _avlt_node_t *_top,
 				_avlt_node_t *_middle, _avlt_node_t *_bottom)
 {
 	_avlt_node_t *_parent = _top->_parent;
+
+	_AVLT_STAT_ADD(_avlt, _rotations[_LR], 1);
 	_top->_left_child = _bottom->_right_child;
 	if (_top->_left_child != NULL) {
 		_top->_left_child->_parent = _top;
@@ -226,12 +374,17 @@ static inline void _lr_rotation(avlt_t *_avlt, _avlt_node_t *_top,
 		_avlt->_root = _bottom;
 		_bottom->_parent = NULL;
 	}
+	_update_count(_avlt, _top);
+	_update_count(_avlt, _middle);
+	_update_count(_avlt, _bottom);
 }
 
 static inline void _ll_rotation(avlt_t *_avlt, _avlt_node_t *_top,
 				_avlt_node_t *_middle)
 {
 	_avlt_node_t *_parent = _top->_parent;
+
+	_AVLT_STAT_ADD(_avlt, _rotations[_LL], 1);
 	_top->_right_child = _middle->_left_child;
 	if (_top->_right_child != NULL) {
 		_top->_right_child->_parent = _top;
@@ -251,12 +404,16 @@ static inline void _ll_rotation(avlt_t *_avlt, _avlt_node_t *_top,
 		_avlt->_root = _middle;
 		_middle->_parent = NULL;
 	}
+	_update_count(_avlt, _top);
+	_update_count(_avlt, _middle);
 }
 
 static inline void _rl_rotation(avlt_t *_avlt, _avlt_node_t *_top,
 				_avlt_node_t *_middle, _avlt_node_t *_bottom)
 {
 	_avlt_node_t *_parent = _top->_parent;
+
+	_AVLT_STAT_ADD(_avlt, _rotations[_RL], 1);
 	_top->_right_child = _bottom->_left_child;
 	if (_top->_right_child != NULL) {
 		_top->_right_child->_parent = _top;
@@ -282,6 +439,9 @@ static inline void _rl_rotation(avlt_t *_avlt, _avlt_node_t *_top,
 		_avlt->_root = _bottom;
 		_bottom->_parent = NULL;
 	}
+	_update_count(_avlt, _top);
+	_update_count(_avlt, _middle);
+	_update_count(_avlt, _bottom);
 }
 
 static inline void _balance_after_insert(avlt_t *_avlt, _avlt_node_t *_node,
@@ -290,13 +450,16 @@ static inline void _balance_after_insert(avlt_t *_avlt, _avlt_node_t *_node,
 	assert(_node->_balance <= 1 && _node->_balance >= -1);
 	short balance = _node->_balance;
 	if (balance == 0) {
+		_stats_rebalance(_avlt, 0);
 		return;
 	}
 	_avlt_node_t *prevprev = _new_node;
 	_avlt_node_t *prev = _node;
 	_avlt_node_t *curr = _node->_parent;
+	uint64_t _levels = 0;
 
 	while (curr != NULL) {
+		_levels++;
 		assert(curr->_balance <= 1 && curr->_balance >= -1);
 		if (curr->_left_child == prev) {
 			curr->_balance = curr->_balance + _LEFT;
@@ -347,19 +510,23 @@ static inline void _balance_after_insert(avlt_t *_avlt, _avlt_node_t *_node,
 		prev = curr;
 		curr = curr->_parent;
 	}  // end of while (_node != NULL)
+	_stats_rebalance(_avlt, _levels);
 }
 
 static inline void _balance_after_delete(avlt_t *_avlt, _avlt_node_t *_node)
 {
 	if (_node->_balance == _LEFT || _node->_balance == _RIGHT) {
+		_stats_rebalance(_avlt, 0);
 		return;
 	}
 
 	_avlt_node_t *_top = _node;
 	_avlt_node_t *_middle;
 	_avlt_node_t *_bottom;
+	uint64_t _levels = 0;
 
 	while (_top != NULL) {
+		_levels++;
 		if (_top->_balance == _LEFT2X) {
 			_middle = _top->_left_child;
 
@@ -408,41 +575,85 @@ static inline void _balance_after_delete(avlt_t *_avlt, _avlt_node_t *_node)
 		}
 		_top = _top->_parent;
 	}
+	_stats_rebalance(_avlt, _levels);
+}
+
+// Where a descent for _key starts.  Without a finger that is the root.
+// With one, it is the lowest node on the finger's path to the root whose
+// key range spans _key.  For a _key above the finger, every such range
+// already reaches below _key, and a range is capped from above by the
+// key of the first ancestor that holds it in its left subtree; the
+// climb stops at the first cap above _key.  Mirror that for a _key
+// below the finger.  Near the finger the descent is O(log d) for a key
+// d entries away.
+static inline _avlt_node_t * _descent_start(avlt_t *_avlt, uint _key)
+{
+	_avlt_node_t *_node = _avlt->_finger;
+	_avlt_node_t *_start = _node;
+	_avlt_node_t *_parent;
+	bool _above;
+
+	if (_node == NULL) {
+		return _avlt->_root;
+	}
+	_above = (_key > _node->_key);
+	while ((_parent = _node->_parent) != NULL) {
+		if ((_above && _parent->_left_child == _node) ||
+		    (!_above && _parent->_right_child == _node)) {
+			_AVLT_STAT_ADD(_avlt, _compares, 1);
+			if (_key == _parent->_key) {
+				return _parent;
+			}
+			if ((_key < _parent->_key) == _above) {
+				break;
+			}
+			_start = _parent;
+		}
+		_node = _parent;
+	}
+	return _start;
+}
+
+static inline void _set_finger(avlt_t *_avlt, _avlt_node_t *_node)
+{
+	if (_avlt->_flags & AVLT_FINGER) {
+		_avlt->_finger = _node;
+	}
+}
+
+// Moves the finger off _node before _node leaves the tree.
+static inline void _finger_forget(avlt_t *_avlt, _avlt_node_t *_node)
+{
+	if (_avlt->_finger == _node) {
+		_avlt->_finger = avlt_iter_next(_node);
+		if (_avlt->_finger == NULL) {
+			_avlt->_finger = avlt_iter_prev(_node);
+		}
+	}
 }
 
 // returns NULL if key is not found
 static inline _avlt_node_t * _map_search(avlt_t *_avlt, uint _key)
 {
-	_avlt_node_t *_curr = _avlt->_root;
+	_avlt_node_t *_curr = _descent_start(_avlt, _key);
+	_avlt_node_t *_last = _curr;
+	_AVLT_STAT_ADD(_avlt, _descents, 1);
 	while (_curr != NULL) {
 		int _cmp_result = compare(_curr->_key, _key);
+		_AVLT_STAT_ADD(_avlt, _compares, 1);
+		_last = _curr;
 		if (_cmp_result == _LEFT) {
 			_curr = _curr->_left_child;
 		} else if (_cmp_result == _RIGHT) {
 			_curr = _curr->_right_child;
 		} else {
-			return _curr;
+			break;
 		}
 	}  // end of while (curr != NULL) {
+	_set_finger(_avlt, _last);
 	return _curr;
 }
 
-static int _height(_avlt_node_t *_node) {
-	int _left_height = 0;
-	int _right_height = 0;
-	if (_node->_left_child != NULL) {
-		_left_height = _height(_node->_left_child) + 1;
-	}
-	if (_node->_right_child != NULL) {
-		_right_height = _height(_node->_right_child) + 1;
-	}
-	if (_left_height > _right_height) {
-		return _left_height;
-	} else {
-		return _right_height;
-	}
-}
-
 int avlt_validate_order(_avlt_node_t *_node)
 {
 	uint _left_key = 0;
@@ -479,6 +690,65 @@ void avlt_init(avlt_t *_avlt)
 {
 	_avlt->_root = NULL;
 	_avlt->_size = 0;
+	_avlt->_pool = NULL;
+	_avlt->_flags = 0;
+	_avlt->_finger = NULL;
+	avlt_stats_reset(_avlt);
+}
+
+// Same as avlt_init(), but nodes are carved out of slab chunks of
+// _chunk_nodes nodes each and recycled through a free list instead of
+// going through malloc/free on every insert/delete.
+void avlt_init_pool(avlt_t *_avlt, size_t _chunk_nodes)
+{
+	avlt_init(_avlt);
+	_avlt->_pool = (_avlt_pool_t *) malloc(sizeof(_avlt_pool_t));
+	assert(_avlt->_pool != NULL);
+	_avlt->_pool->_chunks = NULL;
+	_avlt->_pool->_free_list = NULL;
+	_avlt->_pool->_chunk_nodes =
+		(_chunk_nodes == 0) ? AVLT_POOL_CHUNK_NODES : _chunk_nodes;
+	_avlt->_pool->_chunk_used = 0;
+	_avlt->_pool->_refs = 1;
+}
+
+// Initializes an empty tree that allocates from the same pool as
+// _owner (or from malloc if _owner has no pool).  Trees have to share
+// an allocator before nodes can move between them with avlt_join() or
+// the set operations.
+void avlt_init_shared_pool(avlt_t *_avlt, avlt_t *_owner)
+{
+	avlt_init(_avlt);
+	_avlt->_pool = _owner->_pool;
+	if (_avlt->_pool != NULL) {
+		_avlt->_pool->_refs++;
+	}
+}
+
+// Releases every chunk of the pool at once.  All nodes go with it, so
+// the tree is left empty and malloc-backed.  If other trees still share
+// the pool, only this tree's nodes are returned to it.
+void avlt_destroy_pool(avlt_t *_avlt)
+{
+	_avlt_pool_chunk_t *_chunk;
+	uint _flags = _avlt->_flags;
+	if (_avlt->_pool == NULL) {
+		return;
+	}
+	if (--_avlt->_pool->_refs > 0) {
+		_free_subtree(_avlt, _avlt->_root);
+		avlt_init(_avlt);
+		_avlt->_flags = _flags;
+		return;
+	}
+	while (_avlt->_pool->_chunks != NULL) {
+		_chunk = _avlt->_pool->_chunks;
+		_avlt->_pool->_chunks = _chunk->_next;
+		free(_chunk);
+	}
+	free(_avlt->_pool);
+	avlt_init(_avlt);
+	_avlt->_flags = _flags;
 }
 
 void * avlt_search(avlt_t *_avlt, uint _key)
@@ -491,25 +761,91 @@ void * avlt_search(avlt_t *_avlt, uint _key)
 	}
 }
 
-void avlt_insert(avlt_t *_avlt, uint _key, void *_value)
+// Looks up _n keys, storing each value (or NULL) in _out.  Up to
+// AVLT_BATCH_INFLIGHT lookups advance round-robin, one level per turn,
+// and each step prefetches the child it moves to.  By the time a lookup
+// gets its next turn the node is usually in cache, so the misses of
+// different keys overlap instead of being paid one after another.
+void avlt_search_batch(avlt_t *_avlt, const uint *_keys, void **_out,
+		       size_t _n)
 {
-	int _cmp_result;
-	_avlt_node_t *_curr = _avlt->_root;
-	_avlt_node_t *_new_node = _create_new_node();
+	_avlt_node_t *_curr[AVLT_BATCH_INFLIGHT];
+	size_t _idx[AVLT_BATCH_INFLIGHT];
+	size_t _next = 0;
+	int _active = 0;
+	int _i;
 
-	_avlt->_size++;
+	if (_avlt->_root == NULL) {
+		for (_next = 0; _next < _n; _next++) {
+			_out[_next] = NULL;
+		}
+		return;
+	}
+	_AVLT_STAT_ADD(_avlt, _descents, _n);
 
-	_new_node->_key = _key;
-	_new_node->_value = _value;
+	for (_i = 0; _i < AVLT_BATCH_INFLIGHT; _i++) {
+		if (_next < _n) {
+			_curr[_i] = _avlt->_root;
+			_idx[_i] = _next++;
+			_active++;
+		} else {
+			_curr[_i] = NULL;
+		}
+	}
 
-	if (_curr == NULL) {
-		_avlt->_root = _new_node;
-		return;
+	while (_active > 0) {
+		for (_i = 0; _i < AVLT_BATCH_INFLIGHT; _i++) {
+			_avlt_node_t *_node = _curr[_i];
+			int _cmp_result;
+			if (_node == NULL) {
+				continue;
+			}
+			_cmp_result = compare(_node->_key, _keys[_idx[_i]]);
+			_AVLT_STAT_ADD(_avlt, _compares, 1);
+			if (_cmp_result == _LEFT) {
+				_node = _node->_left_child;
+			} else if (_cmp_result == _RIGHT) {
+				_node = _node->_right_child;
+			} else {
+				_out[_idx[_i]] = _node->_value;
+				_node = NULL;
+			}
+
+			if (_node != NULL) {
+				__builtin_prefetch(_node);
+				_curr[_i] = _node;
+				continue;
+			}
+			if (_cmp_result != _EQUAL) {
+				_out[_idx[_i]] = NULL;
+			}
+			// Lookup finished, refill the slot with the next key.
+			if (_next < _n) {
+				_curr[_i] = _avlt->_root;
+				_idx[_i] = _next++;
+			} else {
+				_curr[_i] = NULL;
+				_active--;
+			}
+		}
 	}
+}
+
+// Descends once for _key.  Returns the entry if it exists; otherwise
+// links a new entry with a NULL value where the descent ended, and
+// rebalances.  *_inserted tells the two cases apart.
+static _avlt_node_t * _find_or_insert(avlt_t *_avlt, uint _key,
+				      bool *_inserted)
+{
+	int _cmp_result = _EQUAL;
+	_avlt_node_t *_curr = _descent_start(_avlt, _key);
+	_avlt_node_t *_new_node;
 
 	// Find insertion point, the _parent of new node.
+	_AVLT_STAT_ADD(_avlt, _descents, 1);
 	while (_curr != NULL) {
 		_cmp_result = compare(_curr->_key, _key);
+		_AVLT_STAT_ADD(_avlt, _compares, 1);
 		if (_cmp_result == _LEFT) {
 			if (_curr->_left_child != NULL)
 				_curr = _curr->_left_child;
@@ -521,24 +857,158 @@ void avlt_insert(avlt_t *_avlt, uint _key, void *_value)
 			else
 				break;
 		} else {
-			fprintf(stderr, "ERROR: Redundant key (%u) value "
-				"found while inserting!\n", _key);
-			assert(false);
+			*_inserted = false;
+			_set_finger(_avlt, _curr);
+			return _curr;
 		}
 	}  // end of while (curr != NULL) {
 
+	*_inserted = true;
+	_new_node = _create_new_node(_avlt);
+	_new_node->_key = _key;
+	_avlt->_size++;
+	_set_finger(_avlt, _new_node);
+
+	if (_curr == NULL) {
+		_avlt->_root = _new_node;
+		return _new_node;
+	}
+
 	_new_node->_parent = _curr;
+	_add_count_to_root(_avlt, _curr, 1);
 	if (_cmp_result == _LEFT) {
 		_curr->_left_child = _new_node;
 		_curr->_balance = _curr->_balance + _LEFT;
-
-		_balance_after_insert(_avlt, _curr, _new_node);
 	} else {
 		_curr->_right_child = _new_node;
 		_curr->_balance = _curr->_balance + _RIGHT;
+	}
+	_balance_after_insert(_avlt, _curr, _new_node);
+	return _new_node;
+}
+
+// Unlinks _node from the tree and rebalances, without freeing it.
+// When _node has children, its in-order neighbour is moved into its
+// place (rather than copying the neighbour's entry into _node), so
+// every other node keeps its entry and handles to them stay valid.
+static void _unlink_node(avlt_t *_avlt, _avlt_node_t *_node)
+{
+	_avlt_node_t *_parent;
+	_avlt_node_t *_avlt_node_to_attach;
+
+	_avlt->_size--;
+
+	// Find max of left sutree or min of right subtree
+	_avlt_node_t *_replacement_node = _get_max_of_left_subtree(_node);
+	if (_replacement_node != NULL) {
+		_avlt_node_to_attach = _replacement_node->_left_child;
+	} else {
+		_replacement_node = _get_min_of_right_subtree(_node);
+		_avlt_node_to_attach = (_replacement_node != NULL) ?
+			_replacement_node->_right_child : NULL;
+	}
+
+	// The node that physically leaves its spot is the replacement
+	// node if there is one, or _node itself if it is a leaf.  Either
+	// way it has at most one child.
+	_avlt_node_t *_leaving = (_replacement_node != NULL) ?
+		_replacement_node : _node;
+	_parent = _leaving->_parent;
+	if (_parent == NULL) {
+		_avlt->_root = NULL;
+		return;
+	}
 
-		_balance_after_insert(_avlt, _curr, _new_node);
+	// Attach the child from the leaving node to the _parent, and
+	// adjust the balance.
+	if (_parent->_left_child == _leaving) {
+		_parent->_left_child = _avlt_node_to_attach;
+		_parent->_balance = _parent->_balance - _LEFT;
+	} else if (_parent->_right_child == _leaving) {
+		_parent->_right_child = _avlt_node_to_attach;
+		_parent->_balance = _parent->_balance - _RIGHT;
+	} else {
+		assert(false);
+	}
+	if (_avlt_node_to_attach != NULL) {
+		_avlt_node_to_attach->_parent = _parent;
+	}
+	_add_count_to_root(_avlt, _parent, -1);
+
+	if (_replacement_node != NULL) {
+		// Put the replacement node where _node was.  _node's
+		// children and balance already reflect the detach above.
+		_replacement_node->_left_child = _node->_left_child;
+		if (_replacement_node->_left_child != NULL) {
+			_replacement_node->_left_child->_parent =
+				_replacement_node;
+		}
+		_replacement_node->_right_child = _node->_right_child;
+		if (_replacement_node->_right_child != NULL) {
+			_replacement_node->_right_child->_parent =
+				_replacement_node;
+		}
+		_replacement_node->_balance = _node->_balance;
+		_replacement_node->_count = _node->_count;
+		_replacement_node->_parent = _node->_parent;
+		if (_node->_parent == NULL) {
+			_avlt->_root = _replacement_node;
+		} else if (_node->_parent->_left_child == _node) {
+			_node->_parent->_left_child = _replacement_node;
+		} else {
+			_node->_parent->_right_child = _replacement_node;
+		}
+		if (_parent == _node) {
+			_parent = _replacement_node;
+		}
 	}
+
+	_balance_after_delete(_avlt, _parent);
+}
+
+// Returns a handle to the new entry.
+avlt_itr_t avlt_insert(avlt_t *_avlt, uint _key, void *_value)
+{
+	bool _inserted;
+	_avlt_node_t *_node = _find_or_insert(_avlt, _key, &_inserted);
+	if (!_inserted) {
+		fprintf(stderr, "ERROR: Redundant key (%u) value "
+			"found while inserting!\n", _key);
+		assert(false);
+	}
+	_node->_value = _value;
+	return _node;
+}
+
+// Returns the handle of the entry for _key, or NULL.
+avlt_itr_t avlt_find(avlt_t *_avlt, uint _key)
+{
+	return _map_search(_avlt, _key);
+}
+
+// Returns the entry for _key, creating it with a NULL value if needed,
+// in a single descent.  *_inserted (if not NULL) tells whether it was
+// created.  The value is read and written through
+// avlt_iter_value_slot().
+avlt_itr_t avlt_find_or_insert(avlt_t *_avlt, uint _key, bool *_inserted)
+{
+	bool _created;
+	_avlt_node_t *_node = _find_or_insert(_avlt, _key, &_created);
+	if (_inserted != NULL) {
+		*_inserted = _created;
+	}
+	return _node;
+}
+
+// Inserts or overwrites the value for _key in a single descent and
+// returns the previous value (NULL if the key was new).
+void *avlt_upsert(avlt_t *_avlt, uint _key, void *_value)
+{
+	bool _inserted;
+	_avlt_node_t *_node = _find_or_insert(_avlt, _key, &_inserted);
+	void *_old_value = _node->_value;
+	_node->_value = _value;
+	return _old_value;
 }
 
 void avlt_delete(avlt_t *_avlt, uint _key)
@@ -547,70 +1017,933 @@ void avlt_delete(avlt_t *_avlt, uint _key)
 
 	assert(_avlt_node_to_delete != NULL);
 
+	_finger_forget(_avlt, _avlt_node_to_delete);
+	_unlink_node(_avlt, _avlt_node_to_delete);
+	_free_node(_avlt, _avlt_node_to_delete);
+}
+
+// Deletes the entry behind _handle without searching for it and returns
+// its value.  Only _handle itself becomes invalid.
+void *avlt_delete_handle(avlt_t *_avlt, avlt_itr_t _handle)
+{
+	void *_value = _handle->_value;
+	_finger_forget(_avlt, _handle);
+	_unlink_node(_avlt, _handle);
+	_free_node(_avlt, _handle);
+	return _value;
+}
+
+// Frees every node below and including _node in one iterative
+// post-order walk and returns how many there were.  Children are
+// unhooked as they are freed, so the walk never revisits a node.
+static size_t _free_subtree(avlt_t *_avlt, _avlt_node_t *_node)
+{
+	size_t _cnt = 0;
+	_avlt_node_t *_parent = (_node != NULL) ? _node->_parent : NULL;
+	_avlt_node_t *_stop = _parent;
+
+	while (_node != _stop) {
+		if (_node->_left_child != NULL) {
+			_node = _node->_left_child;
+		} else if (_node->_right_child != NULL) {
+			_node = _node->_right_child;
+		} else {
+			_parent = _node->_parent;
+			if (_parent != NULL) {
+				if (_parent->_left_child == _node) {
+					_parent->_left_child = NULL;
+				} else {
+					_parent->_right_child = NULL;
+				}
+			}
+			_free_node(_avlt, _node);
+			_cnt++;
+			_node = _parent;
+		}
+	}
+	return _cnt;
+}
+
+// Number of levels below and including _node, found in O(log n) by
+// following the taller child.
+static int _subtree_height(_avlt_node_t *_node)
+{
+	int _height = 0;
+	while (_node != NULL) {
+		_height++;
+		_node = (_node->_balance == _RIGHT) ?
+			_node->_right_child : _node->_left_child;
+	}
+	return _height;
+}
+
+// Recomputes _count of _node and all of its ancestors.
+static inline void _update_count_to_root(avlt_t *_avlt, _avlt_node_t *_node)
+{
+	if (_avlt->_flags & AVLT_ORDER_STAT) {
+		while (_node != NULL) {
+			_update_count(_avlt, _node);
+			_node = _node->_parent;
+		}
+	}
+}
+
+// Joins two detached subtrees of the given heights and a detached node
+// _mid, where every key in _left < _mid->_key < every key in _right,
+// returns the new root and sets *_joined_height to its height.  The
+// shorter subtree is hung next to the node of matching height on the
+// near spine of the taller one, and the growth is rebalanced the same
+// way as after an insertion.  O(|height difference| + 1).
+static _avlt_node_t * _join(avlt_t *_avlt, _avlt_node_t *_left,
+			    int _left_height, _avlt_node_t *_mid,
+			    _avlt_node_t *_right, int _right_height,
+			    int *_joined_height)
+{
+	int _height;
+	avlt_t _tmp = *_avlt;
+	_avlt_node_t *_curr;
 	_avlt_node_t *_parent = NULL;
-	_avlt_node_t *_avlt_node_to_attach = NULL;
+	_avlt_node_t *_top;
+	int _top_balance;
 
-	_avlt->_size--;
-	if (_avlt->_size == 0) {
-		assert(_parent == NULL);
-		_avlt->_root = NULL;
-		free(_avlt_node_to_delete);
+	_stats_tmp_begin(&_tmp);
+	_mid->_parent = NULL;
+	if (_left_height - _right_height <= 1 &&
+	    _right_height - _left_height <= 1) {
+		_mid->_left_child = _left;
+		_mid->_right_child = _right;
+		if (_left != NULL) {
+			_left->_parent = _mid;
+		}
+		if (_right != NULL) {
+			_right->_parent = _mid;
+		}
+		_mid->_balance = _left_height - _right_height;
+		_update_count(_avlt, _mid);
+		*_joined_height = ((_left_height > _right_height) ?
+				   _left_height : _right_height) + 1;
+		return _mid;
+	}
+
+	_top = (_left_height > _right_height) ? _left : _right;
+	_top_balance = _top->_balance;
+	if (_left_height > _right_height) {
+		// Walk down the right spine of _left to height
+		// _right_height or _right_height + 1.
+		_tmp._root = _left;
+		_curr = _left;
+		_height = _left_height;
+		while (_height > _right_height + 1) {
+			_height -= (_curr->_balance == _LEFT) ? 2 : 1;
+			_parent = _curr;
+			_curr = _curr->_right_child;
+		}
+		_mid->_left_child = _curr;
+		_mid->_right_child = _right;
+		_mid->_balance = _height - _right_height;
+		_parent->_right_child = _mid;
+	} else {
+		// Mirror image: walk down the left spine of _right.
+		_tmp._root = _right;
+		_curr = _right;
+		_height = _right_height;
+		while (_height > _left_height + 1) {
+			_height -= (_curr->_balance == _RIGHT) ? 2 : 1;
+			_parent = _curr;
+			_curr = _curr->_left_child;
+		}
+		_mid->_left_child = _left;
+		_mid->_right_child = _curr;
+		_mid->_balance = _left_height - _height;
+		_parent->_left_child = _mid;
+	}
+	_mid->_parent = _parent;
+	if (_mid->_left_child != NULL) {
+		_mid->_left_child->_parent = _mid;
+	}
+	if (_mid->_right_child != NULL) {
+		_mid->_right_child->_parent = _mid;
+	}
+	_update_count_to_root(&_tmp, _mid);
+
+	// _mid took the place of _curr and is one level taller.
+	if (_mid->_balance == 0) {
+		// Only happens when _parent leaned towards the other side,
+		// so _parent is now balanced and nothing above changes.
+		_parent->_balance += (_parent->_right_child == _mid) ?
+			_RIGHT : _LEFT;
+		assert(_parent->_balance == 0);
+	} else {
+		_balance_after_insert(&_tmp, _mid, _curr);
+	}
+	_stats_tmp_end(_avlt, &_tmp);
+
+	// The taller tree grew only if the growth reached its root, which
+	// was balanced and leans now.  A rotation at the root absorbs it.
+	*_joined_height = ((_left_height > _right_height) ?
+			   _left_height : _right_height);
+	if (_tmp._root == _top && _top_balance == 0 && _top->_balance != 0) {
+		(*_joined_height)++;
+	}
+	return _tmp._root;
+}
+
+// Joins two detached subtrees of the given heights with every key in
+// _left < every key in _right, using the minimum of _right as the middle
+// node, and sets *_joined_height.  Unlinking the minimum and measuring
+// what is left of _right both follow one path of _right, so this is
+// O(height of _right).
+static _avlt_node_t * _join2(avlt_t *_avlt, _avlt_node_t *_left,
+			     int _left_height, _avlt_node_t *_right,
+			     int _right_height, int *_joined_height)
+{
+	avlt_t _tmp = *_avlt;
+	_avlt_node_t *_mid;
+
+	if (_left == NULL) {
+		*_joined_height = _right_height;
+		return _right;
+	} else if (_right == NULL) {
+		*_joined_height = _left_height;
+		return _left;
+	}
+	_stats_tmp_begin(&_tmp);
+	_tmp._root = _right;
+	_mid = avlt_get_itr(&_tmp);
+	_unlink_node(&_tmp, _mid);
+	_stats_tmp_end(_avlt, &_tmp);
+	_mid->_left_child = NULL;
+	_mid->_right_child = NULL;
+	return _join(_avlt, _left, _left_height, _mid, _tmp._root,
+		     _subtree_height(_tmp._root), _joined_height);
+}
+
+// Splits the detached subtree _root of height _height around _key: keys
+// below it end up in *_left and keys above it in *_right, both detached,
+// with their heights in *_left_height and *_right_height.  The node
+// holding _key, if any, is returned detached; otherwise NULL is
+// returned.  Each level joins pieces whose heights differ by about the
+// height of the level, so the joins add up to O(log n).
+static _avlt_node_t * _split(avlt_t *_avlt, _avlt_node_t *_root, int _height,
+			     uint _key, _avlt_node_t **_left,
+			     int *_left_height, _avlt_node_t **_right,
+			     int *_right_height)
+{
+	_avlt_node_t *_left_child;
+	_avlt_node_t *_right_child;
+	_avlt_node_t *_found;
+	int _left_child_height;
+	int _right_child_height;
+
+	if (_root == NULL) {
+		*_left = NULL;
+		*_right = NULL;
+		*_left_height = 0;
+		*_right_height = 0;
+		return NULL;
+	}
+
+	_left_child = _root->_left_child;
+	_right_child = _root->_right_child;
+	_left_child_height = _height - 1 - (_root->_balance == _RIGHT);
+	_right_child_height = _height - 1 - (_root->_balance == _LEFT);
+	if (_left_child != NULL) {
+		_left_child->_parent = NULL;
+	}
+	if (_right_child != NULL) {
+		_right_child->_parent = NULL;
+	}
+	_root->_left_child = NULL;
+	_root->_right_child = NULL;
+
+	int _cmp_result = compare(_root->_key, _key);
+	if (_cmp_result == _LEFT) {
+		_found = _split(_avlt, _left_child, _left_child_height, _key,
+				_left, _left_height, &_left_child,
+				&_left_child_height);
+		*_right = _join(_avlt, _left_child, _left_child_height, _root,
+				_right_child, _right_child_height,
+				_right_height);
+	} else if (_cmp_result == _RIGHT) {
+		_found = _split(_avlt, _right_child, _right_child_height, _key,
+				&_right_child, &_right_child_height, _right,
+				_right_height);
+		*_left = _join(_avlt, _left_child, _left_child_height, _root,
+			       _right_child, _right_child_height,
+			       _left_height);
+	} else {
+		*_left = _left_child;
+		*_right = _right_child;
+		*_left_height = _left_child_height;
+		*_right_height = _right_child_height;
+		_root->_parent = NULL;
+		_root->_balance = 0;
+		_root->_count = 1;
+		_found = _root;
+	}
+	return _found;
+}
+
+// Frees every entry.  A tree that is the only user of its node pool
+// drops all of the chunks instead of visiting each node.
+void avlt_clear(avlt_t *_avlt)
+{
+	if (_avlt->_pool != NULL && _avlt->_pool->_refs == 1) {
+		_avlt_pool_t *_pool = _avlt->_pool;
+		while (_pool->_chunks != NULL) {
+			_avlt_pool_chunk_t *_chunk = _pool->_chunks;
+			_pool->_chunks = _chunk->_next;
+			free(_chunk);
+		}
+		_pool->_free_list = NULL;
+		_pool->_chunk_used = 0;
+		_AVLT_STAT_ADD(_avlt, _frees, _avlt->_size);
+	} else {
+		_free_subtree(_avlt, _avlt->_root);
+	}
+	_avlt->_root = NULL;
+	_avlt->_size = 0;
+	_avlt->_finger = NULL;
+}
+
+// Frees every entry and the node pool, if any.
+void avlt_destroy(avlt_t *_avlt)
+{
+	if (_avlt->_pool != NULL) {
+		avlt_destroy_pool(_avlt);
+	} else {
+		avlt_clear(_avlt);
+	}
+}
+
+// Removes every entry with _lo <= key <= _hi and returns how many were
+// removed.  The tree is split at both ends, the middle part is freed and
+// the outer parts are joined again: O(log n) plus the freed entries.
+size_t avlt_erase_range(avlt_t *_avlt, uint _lo, uint _hi)
+{
+	_avlt_node_t *_below;
+	_avlt_node_t *_rest;
+	_avlt_node_t *_middle;
+	_avlt_node_t *_above;
+	_avlt_node_t *_found;
+	int _below_height;
+	int _rest_height;
+	int _middle_height;
+	int _above_height;
+	size_t _removed = 0;
+
+	if (_lo > _hi || _avlt->_root == NULL) {
+		return 0;
+	}
+
+	_avlt->_finger = NULL;
+	_found = _split(_avlt, _avlt->_root, _subtree_height(_avlt->_root),
+			_lo, &_below, &_below_height, &_rest, &_rest_height);
+	_removed += _free_subtree(_avlt, _found);
+	_found = _split(_avlt, _rest, _rest_height, _hi, &_middle,
+			&_middle_height, &_above, &_above_height);
+	_removed += _free_subtree(_avlt, _found);
+	_removed += _free_subtree(_avlt, _middle);
+
+	_avlt->_root = _join2(_avlt, _below, _below_height, _above,
+			      _above_height, &_rest_height);
+	_avlt->_size -= _removed;
+	return _removed;
+}
+
+// Trees whose nodes get mixed must share an allocator, and must agree
+// on order statistics or the subtree sizes of one of them are stale.
+static void _check_compatible(avlt_t *_a, avlt_t *_b)
+{
+	if (_a->_pool != _b->_pool) {
+		fprintf(stderr, "ERROR: Trees do not share an allocator!\n");
+		assert(false);
+	}
+	if ((_a->_flags & AVLT_ORDER_STAT) != (_b->_flags & AVLT_ORDER_STAT)) {
+		fprintf(stderr, "ERROR: Only one of the trees keeps order "
+			"statistics!\n");
+		assert(false);
+	}
+}
+
+static size_t _count_entries(avlt_t *_avlt)
+{
+	size_t _cnt = 0;
+	avlt_itr_t _itr;
+	if (_avlt->_flags & AVLT_ORDER_STAT) {
+		return _count(_avlt->_root);
+	}
+	for (_itr = avlt_get_itr(_avlt); _itr != NULL;
+	     _itr = avlt_iter_next(_itr)) {
+		_cnt++;
+	}
+	return _cnt;
+}
+
+// Moves the entries of _avlt with keys below _key into _left and the
+// rest into _right, leaving _avlt empty.  _left and _right are
+// initialized here and share _avlt's allocator and options.  The split
+// itself is O(log n), but sizing _left walks all of it, O(n), unless
+// order statistics are enabled.
+void avlt_split(avlt_t *_avlt, uint _key, avlt_t *_left, avlt_t *_right)
+{
+	_avlt_node_t *_found;
+	_avlt_node_t *_above;
+	int _left_height;
+	int _above_height;
+	int _right_height;
+
+	avlt_init_shared_pool(_left, _avlt);
+	avlt_init_shared_pool(_right, _avlt);
+	_left->_flags = _avlt->_flags;
+	_right->_flags = _avlt->_flags;
+
+	_found = _split(_avlt, _avlt->_root, _subtree_height(_avlt->_root),
+			_key, &_left->_root, &_left_height, &_above,
+			&_above_height);
+	if (_found != NULL) {
+		_right->_root = _join(_avlt, NULL, 0, _found, _above,
+				      _above_height, &_right_height);
+	} else {
+		_right->_root = _above;
+	}
+	_left->_size = _count_entries(_left);
+	_right->_size = _avlt->_size - _left->_size;
+	_avlt->_root = NULL;
+	_avlt->_size = 0;
+	_avlt->_finger = NULL;
+}
+
+// Joins _right and a new entry (_key, _value) onto _left, leaving _right
+// empty.  Every key in _left must be below _key and every key in _right
+// above it, and both trees must share an allocator and agree on order
+// statistics.  O(log n).
+void avlt_join(avlt_t *_left, uint _key, void *_value, avlt_t *_right)
+{
+	avlt_itr_t _max = avlt_get_last_itr(_left);
+	avlt_itr_t _min = avlt_get_itr(_right);
+	_avlt_node_t *_mid;
+	int _height;
+
+	_check_compatible(_left, _right);
+	if ((_max != NULL && _max->_key >= _key) ||
+	    (_min != NULL && _min->_key <= _key)) {
+		fprintf(stderr, "ERROR: Key (%u) does not separate the trees "
+			"being joined!\n", _key);
+		assert(false);
+	}
+	_mid = _create_new_node(_left);
+	_mid->_key = _key;
+	_mid->_value = _value;
+	_left->_root = _join(_left, _left->_root,
+			     _subtree_height(_left->_root), _mid,
+			     _right->_root, _subtree_height(_right->_root),
+			     &_height);
+	_left->_size += _right->_size + 1;
+	_right->_root = NULL;
+	_right->_size = 0;
+	_right->_finger = NULL;
+}
+
+enum _avlt_setop_type {
+	_UNION,
+	_INTERSECTION,
+	_DIFFERENCE,
+};
+
+// One set operation on two detached subtrees.  Nodes that drop out are
+// not freed right away (the pool is not thread-safe); whole detached
+// subtrees are chained through _parent of their roots onto _garbage and
+// freed by the caller once every thread is done.
+typedef struct _avlt_setop {
+	avlt_t *_avlt;
+	int _type;
+	int _depth;
+	_avlt_node_t *_t1;
+	_avlt_node_t *_t2;
+	_avlt_node_t *_result;
+	int _t1_height;
+	int _t2_height;
+	int _result_height;
+	_avlt_node_t *_garbage;
+	_avlt_node_t *_garbage_tail;
+} _avlt_setop_t;
+
+static void _setop_discard(_avlt_setop_t *_task, _avlt_node_t *_subtree)
+{
+	if (_subtree == NULL) {
 		return;
 	}
+	_subtree->_parent = NULL;
+	if (_task->_garbage == NULL) {
+		_task->_garbage = _subtree;
+	} else {
+		_task->_garbage_tail->_parent = _subtree;
+	}
+	_task->_garbage_tail = _subtree;
+}
 
-	// Find max of left sutree or min of right subtree
-	_avlt_node_t *_replacement_node =
-		_get_max_of_left_subtree(_avlt_node_to_delete);
-	if (_replacement_node == NULL) {
-		_replacement_node =
-			_get_min_of_right_subtree(_avlt_node_to_delete);
+static void _setop_adopt_garbage(_avlt_setop_t *_task, _avlt_setop_t *_child)
+{
+	if (_child->_garbage == NULL) {
+		return;
 	}
+	if (_task->_garbage == NULL) {
+		_task->_garbage = _child->_garbage;
+	} else {
+		_task->_garbage_tail->_parent = _child->_garbage;
+	}
+	_task->_garbage_tail = _child->_garbage_tail;
+}
 
-	if (_replacement_node != NULL) {
-		// Copy key and value of replacement node to the
-		// _avlt_node_to_delete and assume it is deleted.
-		_avlt_node_to_delete->_key = _replacement_node->_key;
-		_replacement_node->_key = _INIT_VAL;
-		_avlt_node_to_delete->_value = _replacement_node->_value;
-		_replacement_node->_value = NULL;
+static void *_setop_run(void *_arg);
 
-		// Since the replacement node is copied to the
-		// _avlt_node_to_delete, now the replacement node becomes
-		// the one to be deleted.
-		_avlt_node_to_delete = _replacement_node;
+// Runs both halves, the left one on a new thread while the subtree being
+// walked is tall enough (_height levels) and the spawning depth allows it.
+// A new thread works on its own copy of the tree so that it counts into
+// its own counters, which are added back once it is joined.
+static void _setop_recurse(_avlt_setop_t *_task, _avlt_setop_t *_left,
+			   _avlt_setop_t *_right, int _height)
+{
+	pthread_t _tid;
+	avlt_t _copy;
+	bool _spawned = false;
+
+	if (_task->_depth < AVLT_SETOP_PAR_DEPTH &&
+	    _height >= AVLT_SETOP_PAR_MIN_HEIGHT) {
+		_copy = *_task->_avlt;
+		_stats_tmp_begin(&_copy);
+		_left->_avlt = &_copy;
+		_spawned = (pthread_create(&_tid, NULL, _setop_run,
+					   _left) == 0);
+		if (!_spawned) {
+			_left->_avlt = _task->_avlt;
+		}
+	}
+	if (!_spawned) {
+		_setop_run(_left);
 	}
+	_setop_run(_right);
+	if (_spawned) {
+		pthread_join(_tid, NULL);
+		_stats_tmp_end(_task->_avlt, &_copy);
+	}
+	_setop_adopt_garbage(_task, _left);
+	_setop_adopt_garbage(_task, _right);
+}
+
+static void *_setop_run(void *_arg)
+{
+	_avlt_setop_t *_task = (_avlt_setop_t *) _arg;
+	_avlt_setop_t _left = *_task;
+	_avlt_setop_t _right = *_task;
+	_avlt_node_t *_t1 = _task->_t1;
+	_avlt_node_t *_t2 = _task->_t2;
+	_avlt_node_t *_pivot;
+	_avlt_node_t *_found;
+	int _height;
+	int _left_height;
+	int _right_height;
 
-	_parent = _avlt_node_to_delete->_parent;
+	_task->_garbage = NULL;
+	_task->_garbage_tail = NULL;
+	if (_t1 == NULL || _t2 == NULL) {
+		if (_task->_type == _UNION) {
+			_task->_result = (_t1 != NULL) ? _t1 : _t2;
+			_task->_result_height = (_t1 != NULL) ?
+				_task->_t1_height : _task->_t2_height;
+		} else if (_task->_type == _INTERSECTION) {
+			_setop_discard(_task, (_t1 != NULL) ? _t1 : _t2);
+			_task->_result = NULL;
+			_task->_result_height = 0;
+		} else {
+			_setop_discard(_task, _t2);
+			_task->_result = _t1;
+			_task->_result_height = _task->_t1_height;
+		}
+		return NULL;
+	}
 
-	// At this point, _avlt_node_to_delete is guranteed to
-	// have a _parent node and _avlt_node_to_delete has at
-	// most one child node.
+	_left._depth = _right._depth = _task->_depth + 1;
+	_left._garbage = _right._garbage = NULL;
 
-	if (_avlt_node_to_delete->_left_child != NULL) {
-		_avlt_node_to_attach = _avlt_node_to_delete->_left_child;
+	// Union and intersection walk _t1 and split _t2 around it, so _t1's
+	// entries win on equal keys.  Difference walks _t2 and splits _t1.
+	_pivot = (_task->_type == _DIFFERENCE) ? _t2 : _t1;
+	_height = (_pivot == _t1) ? _task->_t1_height : _task->_t2_height;
+	_left_height = _height - 1 - (_pivot->_balance == _RIGHT);
+	_right_height = _height - 1 - (_pivot->_balance == _LEFT);
+	_left._t1 = _t1->_left_child;
+	_right._t1 = _t1->_right_child;
+	_left._t2 = _t2->_left_child;
+	_right._t2 = _t2->_right_child;
+	if (_pivot->_left_child != NULL) {
+		_pivot->_left_child->_parent = NULL;
 	}
-	if (_avlt_node_to_delete->_right_child != NULL) {
-		assert(_avlt_node_to_attach == NULL);
-		_avlt_node_to_attach = _avlt_node_to_delete->_right_child;
+	if (_pivot->_right_child != NULL) {
+		_pivot->_right_child->_parent = NULL;
+	}
+	_pivot->_left_child = NULL;
+	_pivot->_right_child = NULL;
+	_pivot->_balance = 0;
+	_pivot->_count = 1;
+	if (_pivot == _t1) {
+		_left._t1_height = _left_height;
+		_right._t1_height = _right_height;
+		_found = _split(_task->_avlt, _t2, _task->_t2_height,
+				_t1->_key, &_left._t2, &_left._t2_height,
+				&_right._t2, &_right._t2_height);
+	} else {
+		_left._t2_height = _left_height;
+		_right._t2_height = _right_height;
+		_found = _split(_task->_avlt, _t1, _task->_t1_height,
+				_t2->_key, &_left._t1, &_left._t1_height,
+				&_right._t1, &_right._t1_height);
 	}
 
+	_setop_recurse(_task, &_left, &_right, _height);
 
-	// Attach the child from the _avlt_node_to_delete
-	// to the _parent, and adjust the balance.
-	if (_parent->_left_child == _avlt_node_to_delete) {
-		_parent->_left_child = _avlt_node_to_attach;
-		_parent->_balance = _parent->_balance - _LEFT;
-	} else if (_parent->_right_child == _avlt_node_to_delete) {
-		_parent->_right_child = _avlt_node_to_attach;
-		_parent->_balance = _parent->_balance - _RIGHT;
+	switch (_task->_type) {
+	case _UNION:
+		_setop_discard(_task, _found);
+		_task->_result = _join(_task->_avlt, _left._result,
+				       _left._result_height, _t1,
+				       _right._result, _right._result_height,
+				       &_task->_result_height);
+		break;
+	case _INTERSECTION:
+		if (_found != NULL) {
+			_setop_discard(_task, _found);
+			_task->_result = _join(_task->_avlt, _left._result,
+					       _left._result_height, _t1,
+					       _right._result,
+					       _right._result_height,
+					       &_task->_result_height);
+		} else {
+			_setop_discard(_task, _t1);
+			_task->_result = _join2(_task->_avlt, _left._result,
+						_left._result_height,
+						_right._result,
+						_right._result_height,
+						&_task->_result_height);
+		}
+		break;
+	case _DIFFERENCE:
+		_setop_discard(_task, _found);
+		_setop_discard(_task, _t2);
+		_task->_result = _join2(_task->_avlt, _left._result,
+					_left._result_height, _right._result,
+					_right._result_height,
+					&_task->_result_height);
+		break;
 	}
-	if (_avlt_node_to_attach != NULL) {
-		_avlt_node_to_attach->_parent = _parent;
+	return NULL;
+}
+
+// Combines _src into _dst and leaves _src empty.  Entries of _dst win on
+// equal keys.  Both trees must share an allocator and agree on order
+// statistics.
+static void _setop(avlt_t *_dst, avlt_t *_src, int _type)
+{
+	_avlt_setop_t _task;
+	_avlt_node_t *_garbage;
+	size_t _freed = 0;
+
+	_check_compatible(_dst, _src);
+	_task._avlt = _dst;
+	_task._type = _type;
+	_task._depth = 0;
+	_task._t1 = _dst->_root;
+	_task._t2 = _src->_root;
+	_task._t1_height = _subtree_height(_dst->_root);
+	_task._t2_height = _subtree_height(_src->_root);
+	_setop_run(&_task);
+
+	_garbage = _task._garbage;
+	while (_garbage != NULL) {
+		_avlt_node_t *_next = _garbage->_parent;
+		_garbage->_parent = NULL;
+		_freed += _free_subtree(_dst, _garbage);
+		_garbage = _next;
 	}
 
-	free(_avlt_node_to_delete);
+	_dst->_root = _task._result;
+	_dst->_size = _dst->_size + _src->_size - _freed;
+	_dst->_finger = NULL;
+	_src->_root = NULL;
+	_src->_size = 0;
+	_src->_finger = NULL;
+}
+
+// _dst becomes the union of both trees.  O(m log(n / m + 1)) work for
+// sizes m <= n, with independent subtrees merged on separate threads.
+void avlt_union(avlt_t *_dst, avlt_t *_src)
+{
+	_setop(_dst, _src, _UNION);
+}
 
-	_balance_after_delete(_avlt, _parent);
+// _dst keeps only the keys that are also in _src.
+void avlt_intersection(avlt_t *_dst, avlt_t *_src)
+{
+	_setop(_dst, _src, _INTERSECTION);
+}
+
+// _dst drops every key that is in _src.
+void avlt_difference(avlt_t *_dst, avlt_t *_src)
+{
+	_setop(_dst, _src, _DIFFERENCE);
+}
+
+// Builds a perfectly balanced subtree out of _n sorted keys and returns
+// its root; *_height receives the number of levels.  The left half gets
+// the extra key so that _balance is either _EQUAL or _LEFT.
+static _avlt_node_t * _build_sorted(avlt_t *_avlt, const uint *_keys,
+				    void **_values, size_t _n,
+				    _avlt_node_t *_parent, int *_height)
+{
+	int _left_height;
+	int _right_height;
+	size_t _mid = _n / 2;
+	_avlt_node_t *_node;
+
+	if (_n == 0) {
+		*_height = 0;
+		return NULL;
+	}
+
+	_node = _create_new_node(_avlt);
+	_node->_key = _keys[_mid];
+	_node->_value = (_values != NULL) ? _values[_mid] : NULL;
+	_node->_parent = _parent;
+	_node->_left_child = _build_sorted(_avlt, _keys, _values, _mid,
+					   _node, &_left_height);
+	_node->_right_child = _build_sorted(_avlt, _keys + _mid + 1,
+					    (_values != NULL) ?
+					    _values + _mid + 1 : NULL,
+					    _n - _mid - 1, _node,
+					    &_right_height);
+	_node->_balance = _left_height - _right_height;
+	_node->_count = _n;
+	*_height = ((_left_height > _right_height) ?
+		    _left_height : _right_height) + 1;
+	return _node;
+}
+
+// Fills an empty tree from _n strictly increasing keys in O(n).  _values
+// may be NULL, in which case every value is NULL.
+void avlt_build_sorted(avlt_t *_avlt, const uint *_keys, void **_values,
+		       size_t _n)
+{
+	size_t _i;
+	int _height;
+
+	if (_avlt->_size != 0) {
+		fprintf(stderr, "ERROR: Bulk build into a non-empty tree!\n");
+		assert(false);
+	}
+	for (_i = 1; _i < _n; _i++) {
+		if (_keys[_i - 1] >= _keys[_i]) {
+			fprintf(stderr, "ERROR: Keys (%u, %u) are not strictly "
+				"increasing for bulk build!\n",
+				_keys[_i - 1], _keys[_i]);
+			assert(false);
+		}
+	}
+
+	_avlt->_root = _build_sorted(_avlt, _keys, _values, _n, NULL,
+				     &_height);
+	_avlt->_size = _n;
+}
+
+avlt_itr_t avlt_get_itr(avlt_t *_avlt)
+{
+	_avlt_node_t *_curr = _avlt->_root;
+	if (_curr != NULL) {
+		while (_curr->_left_child != NULL) {
+			_curr = _curr->_left_child;
+		}
+	}
+	return _curr;
+}
+
+avlt_itr_t avlt_get_last_itr(avlt_t *_avlt)
+{
+	_avlt_node_t *_curr = _avlt->_root;
+	if (_curr != NULL) {
+		while (_curr->_right_child != NULL) {
+			_curr = _curr->_right_child;
+		}
+	}
+	return _curr;
+}
+
+// Returns the first entry whose key is not less than _key, or NULL.
+avlt_itr_t avlt_lower_bound(avlt_t *_avlt, uint _key)
+{
+	_avlt_node_t *_curr = _avlt->_root;
+	_avlt_node_t *_bound = NULL;
+	_AVLT_STAT_ADD(_avlt, _descents, 1);
+	while (_curr != NULL) {
+		int _cmp_result = compare(_curr->_key, _key);
+		_AVLT_STAT_ADD(_avlt, _compares, 1);
+		if (_cmp_result == _LEFT) {
+			_bound = _curr;
+			_curr = _curr->_left_child;
+		} else if (_cmp_result == _RIGHT) {
+			_curr = _curr->_right_child;
+		} else {
+			return _curr;
+		}
+	}
+	return _bound;
+}
+
+avlt_itr_t avlt_iter_next(avlt_itr_t _avlt_itr)
+{
+	_avlt_node_t *_node = _avlt_itr;
+	if (_node->_right_child != NULL) {
+		_node = _node->_right_child;
+		while (_node->_left_child != NULL) {
+			_node = _node->_left_child;
+		}
+		return _node;
+	}
+	// Climb until we come up from a left child.
+	while (_node->_parent != NULL && _node->_parent->_right_child == _node) {
+		_node = _node->_parent;
+	}
+	return _node->_parent;
+}
+
+avlt_itr_t avlt_iter_prev(avlt_itr_t _avlt_itr)
+{
+	_avlt_node_t *_node = _avlt_itr;
+	if (_node->_left_child != NULL) {
+		_node = _node->_left_child;
+		while (_node->_right_child != NULL) {
+			_node = _node->_right_child;
+		}
+		return _node;
+	}
+	// Climb until we come up from a right child.
+	while (_node->_parent != NULL && _node->_parent->_left_child == _node) {
+		_node = _node->_parent;
+	}
+	return _node->_parent;
+}
+
+void **avlt_iter_value_slot(avlt_itr_t _avlt_itr)
+{
+	return &_avlt_itr->_value;
+}
+
+uint avlt_iter_key(avlt_itr_t _avlt_itr)
+{
+	return _avlt_itr->_key;
+}
+
+void *avlt_iter_value(avlt_itr_t _avlt_itr)
+{
+	return _avlt_itr->_value;
+}
+
+// Calls _callback on every entry with _lo <= key <= _hi in key order and
+// returns how many entries were visited.
+size_t avlt_range(avlt_t *_avlt, uint _lo, uint _hi,
+		  avlt_range_cb_t _callback, void *_arg)
+{
+	size_t _cnt = 0;
+	avlt_itr_t _itr = avlt_lower_bound(_avlt, _lo);
+	while (_itr != NULL && _itr->_key <= _hi) {
+		_cnt++;
+		if (_callback(_itr->_key, _itr->_value, _arg) != 0) {
+			break;
+		}
+		_itr = avlt_iter_next(_itr);
+	}
+	return _cnt;
+}
+
+// Makes lookups and inserts start next to the node accessed last, which
+// pays off when successive keys are close to each other.  Lookups then
+// update the tree, so readers can no longer share it without a lock.
+void avlt_enable_finger(avlt_t *_avlt)
+{
+	_avlt->_flags |= AVLT_FINGER;
+}
+
+// Makes the tree keep subtree sizes so that avlt_rank(), avlt_select()
+// and avlt_count_range() run in O(log n).  Sizes of an existing tree
+// are computed in one O(n) pass.
+void avlt_enable_order_stat(avlt_t *_avlt)
+{
+	_avlt_node_t *_node;
+	_avlt->_flags |= AVLT_ORDER_STAT;
+	for (_node = _first_postorder(_avlt->_root); _node != NULL;
+	     _node = _next_postorder(_node)) {
+		_update_count(_avlt, _node);
+	}
+}
+
+static inline void _check_order_stat(avlt_t *_avlt)
+{
+	if (!(_avlt->_flags & AVLT_ORDER_STAT)) {
+		fprintf(stderr, "ERROR: Order statistics are not enabled!\n");
+		assert(false);
+	}
+}
+
+// Number of keys less than _key, or not greater than _key if _inclusive.
+static size_t _rank(avlt_t *_avlt, uint _key, bool _inclusive)
+{
+	size_t _cnt = 0;
+	_avlt_node_t *_curr = _avlt->_root;
+	while (_curr != NULL) {
+		if (_curr->_key < _key || (_inclusive && _curr->_key == _key)) {
+			_cnt += _count(_curr->_left_child) + 1;
+			_curr = _curr->_right_child;
+		} else {
+			_curr = _curr->_left_child;
+		}
+	}
+	return _cnt;
+}
+
+// Returns the number of keys less than _key.
+size_t avlt_rank(avlt_t *_avlt, uint _key)
+{
+	_check_order_stat(_avlt);
+	return _rank(_avlt, _key, false);
+}
+
+// Returns the entry with the _k-th smallest key (0-based), or NULL if
+// the tree holds _k entries or fewer.
+avlt_itr_t avlt_select(avlt_t *_avlt, size_t _k)
+{
+	_avlt_node_t *_curr = _avlt->_root;
+	_check_order_stat(_avlt);
+	while (_curr != NULL) {
+		size_t _left = _count(_curr->_left_child);
+		if (_k < _left) {
+			_curr = _curr->_left_child;
+		} else if (_k == _left) {
+			return _curr;
+		} else {
+			_k -= _left + 1;
+			_curr = _curr->_right_child;
+		}
+	}
+	return NULL;
+}
+
+// Returns the number of keys in [_lo, _hi].
+size_t avlt_count_range(avlt_t *_avlt, uint _lo, uint _hi)
+{
+	_check_order_stat(_avlt);
+	if (_lo > _hi) {
+		return 0;
+	}
+	return _rank(_avlt, _hi, true) - _rank(_avlt, _lo, false);
 }
 
 static void print_node(_avlt_node_t *_node, int _level, int _print_level)
@@ -638,13 +1971,127 @@ void avlt_print(avlt_t *_avlt)
 		return;
 	}
 	fprintf(stderr, "----------\n");
-	int _h = _height(_avlt->_root);
+	int _h = _subtree_height(_avlt->_root) - 1;
 	for (_i = 0; _i < _h + 1; _i++) {
 		print_node(_avlt->_root, 0, _i);
 		fprintf(stderr, "\n");
 	}
 	fprintf(stderr, "\nHeight [%d], Total [%lld] nodes\n",
-		_height(_avlt->_root), (long long int) _avlt->_size);
+		_h, (long long int) _avlt->_size);
 	fprintf(stderr, "----------\n");
 }
 
+// Fills _stats with the shape of the tree in one iterative walk that
+// follows parent pointers, plus the hot-path counters when built with
+// AVLT_STATS.
+void avlt_stats(avlt_t *_avlt, avlt_stats_t *_stats)
+{
+	_avlt_node_t *_node = _avlt->_root;
+	_avlt_node_t *_prev = NULL;
+	size_t _depth_sum = 0;
+	int _depth = 0;
+
+	memset(_stats, 0, sizeof(*_stats));
+#ifdef AVLT_STATS
+	_stats->_counters = _avlt->_counters;
+#endif
+	while (_node != NULL) {
+		_avlt_node_t *_next;
+		if (_prev == _node->_parent) {
+			// First visit, coming down.
+			_stats->_size++;
+			_depth_sum += _depth;
+			_stats->_depth_hist[(_depth < AVLT_STATS_MAX_DEPTH) ?
+					    _depth :
+					    AVLT_STATS_MAX_DEPTH - 1]++;
+			if (_depth + 1 > _stats->_height) {
+				_stats->_height = _depth + 1;
+			}
+			_next = (_node->_left_child != NULL) ?
+				_node->_left_child : _node->_right_child;
+		} else if (_prev == _node->_left_child) {
+			_next = _node->_right_child;
+		} else {
+			_next = NULL;
+		}
+		_prev = _node;
+		if (_next != NULL) {
+			_node = _next;
+			_depth++;
+		} else {
+			_node = _node->_parent;
+			_depth--;
+		}
+	}
+	if (_stats->_size > 0) {
+		_stats->_avg_depth = (double) _depth_sum / _stats->_size;
+	}
+}
+
+void avlt_stats_reset(avlt_t *_avlt)
+{
+#ifdef AVLT_STATS
+	memset(&_avlt->_counters, 0, sizeof(_avlt->_counters));
+#else
+	(void) _avlt;
+#endif
+}
+
+#ifdef AVLT_STATS
+static double _per_op(uint64_t _cnt, int64_t _ops)
+{
+	return (_ops > 0) ? (double) _cnt / (double) _ops : 0;
+}
+#endif
+
+// Prints _stats in the tab-separated layout of timer_print_stats().
+// With a probe that timed one operation per lapse, the counters are
+// also shown per operation.
+void avlt_stats_print(FILE *_fp, avlt_stats_t *_stats, time_probe_t *_tp)
+{
+	int _i;
+
+	fprintf(_fp, "Type\t%s\t%s\t%s\n", "size", "height", "avg_depth");
+	fprintf(_fp, "Tree\t%zu\t%d\t%.3f\n", _stats->_size,
+		_stats->_height, _stats->_avg_depth);
+	fprintf(_fp, "Type\t%s\t%s\n", "depth", "nodes");
+	for (_i = 0; _i < AVLT_STATS_MAX_DEPTH && _i < _stats->_height; _i++) {
+		fprintf(_fp, "Depth\t%d\t%zu\n", _i, _stats->_depth_hist[_i]);
+	}
+#ifdef AVLT_STATS
+	{
+		_avlt_counters_t *_c = &_stats->_counters;
+		int64_t _ops = (_tp != NULL) ? _tp->num_iter : 0;
+
+		fprintf(_fp, "Type\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s"
+			"\t%s\t%s\n", "descents", "compares", "RR", "RL", "LL",
+			"LR", "rebalances", "levels", "max_levels", "allocs",
+			"frees");
+		fprintf(_fp, "Counts\t%llu\t%llu\t%llu\t%llu\t%llu\t%llu"
+			"\t%llu\t%llu\t%llu\t%llu\t%llu\n",
+			(unsigned long long) _c->_descents,
+			(unsigned long long) _c->_compares,
+			(unsigned long long) _c->_rotations[_RR],
+			(unsigned long long) _c->_rotations[_RL],
+			(unsigned long long) _c->_rotations[_LL],
+			(unsigned long long) _c->_rotations[_LR],
+			(unsigned long long) _c->_rebalances,
+			(unsigned long long) _c->_rebalance_levels,
+			(unsigned long long) _c->_max_rebalance_levels,
+			(unsigned long long) _c->_allocs,
+			(unsigned long long) _c->_frees);
+		fprintf(_fp, "Type\t%s\t%s\t%s\t%s\n", "compares/descent",
+			"rotations/op", "levels/rebalance", "allocs/op");
+		fprintf(_fp, "Ratios\t%.3f\t%.3f\t%.3f\t%.3f\n",
+			_per_op(_c->_compares, _c->_descents),
+			_per_op(_c->_rotations[_RR] + _c->_rotations[_RL] +
+				_c->_rotations[_LL] + _c->_rotations[_LR], _ops),
+			_per_op(_c->_rebalance_levels, _c->_rebalances),
+			_per_op(_c->_allocs, _ops));
+	}
+#else
+	(void) _tp;
+#endif
+	fflush(_fp);
+}
+
@@ -13,6 +13,10 @@ C-based AVLTree implementation.
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "c_timer.h"
 
 #define _LEFT2X (2)
 #define _RIGHT2X (-2)
@@ -31,25 +35,148 @@ enum rotation_type {
 
 #define _INIT_VAL UINT32_MAX
 
+// avlt_t::_flags
+#define AVLT_ORDER_STAT (0x1)	// keep _count up to date
+#define AVLT_FINGER (0x2)	// start descents from _finger
+
 typedef struct _avlt_node {
 	uint _key;
 	void *_value;
 	char _balance;
+	uint _count;	// nodes in this subtree, with AVLT_ORDER_STAT only
 	struct _avlt_node *_parent;
 	struct _avlt_node *_left_child;
 	struct _avlt_node *_right_child;
 } _avlt_node_t;
 
+// Number of lookups avlt_search_batch() keeps in flight at once.
+#define AVLT_BATCH_INFLIGHT (16)
+
+// The set operations hand a subtree to a new thread while fewer than
+// AVLT_SETOP_PAR_DEPTH levels of the recursion have done so (up to
+// 2^AVLT_SETOP_PAR_DEPTH - 1 extra threads) and the subtree is at least
+// AVLT_SETOP_PAR_MIN_HEIGHT levels tall.
+#define AVLT_SETOP_PAR_DEPTH (4)
+#define AVLT_SETOP_PAR_MIN_HEIGHT (14)
+
+// Number of nodes carved out of each slab chunk when 0 is passed to
+// avlt_init_pool().
+#define AVLT_POOL_CHUNK_NODES (1024)
+
+typedef struct _avlt_pool_chunk {
+	struct _avlt_pool_chunk *_next;
+	_avlt_node_t _nodes[];
+} _avlt_pool_chunk_t;
+
+// Slab allocator for tree nodes.  Freed nodes are kept on an intrusive
+// free list (linked through _parent) and handed out again before any
+// new chunk is allocated.
+typedef struct _avlt_pool {
+	_avlt_pool_chunk_t *_chunks;
+	_avlt_node_t *_free_list;
+	size_t _chunk_nodes;
+	size_t _chunk_used;	// nodes handed out from the newest chunk
+	size_t _refs;		// trees allocating from this pool
+} _avlt_pool_t;
+
+// Hot-path counters, compiled in only with -DAVLT_STATS (make
+// DEFS=-DAVLT_STATS).  It changes avlt_t, so every file including this
+// header has to be built the same way.  Updates are plain increments;
+// threads started by avlt_union() and friends count into their own copy,
+// which is added back when the thread is joined.
+#ifdef AVLT_STATS
+typedef struct _avlt_counters {
+	uint64_t _descents;		// key lookups and insert descents
+	uint64_t _compares;		// key comparisons made by them
+	uint64_t _rotations[_LR + 1];	// indexed by _RR, _RL, _LL, _LR
+	uint64_t _rebalances;		// insert/delete rebalancing passes
+	uint64_t _rebalance_levels;	// levels climbed by all of them
+	uint64_t _max_rebalance_levels;
+	uint64_t _allocs;
+	uint64_t _frees;
+} _avlt_counters_t;
+
+#define _AVLT_STAT_ADD(_avlt, _field, _n) ((_avlt)->_counters._field += (_n))
+#else
+#define _AVLT_STAT_ADD(_avlt, _field, _n) ((void) 0)
+#endif
+
 typedef struct c_avlt {
 	_avlt_node_t *_root;
 	size_t _size;
+	_avlt_pool_t *_pool;	// NULL when nodes come from malloc
+	uint _flags;
+	_avlt_node_t *_finger;	// last node accessed, with AVLT_FINGER
+#ifdef AVLT_STATS
+	_avlt_counters_t _counters;
+#endif
 } avlt_t;
 
+// Depths at or beyond AVLT_STATS_MAX_DEPTH - 1 share the last bucket
+// of avlt_stats_t::_depth_hist.  The root is at depth 0.
+#define AVLT_STATS_MAX_DEPTH (64)
+
+typedef struct avlt_stats {
+	size_t _size;
+	int _height;			// levels, 0 for an empty tree
+	double _avg_depth;
+	size_t _depth_hist[AVLT_STATS_MAX_DEPTH];
+#ifdef AVLT_STATS
+	_avlt_counters_t _counters;
+#endif
+} avlt_stats_t;
+
+// Iterators point at tree nodes; NULL is the end.  Nodes never move
+// between entries, so an iterator doubles as a stable handle to its
+// entry: only deleting that entry invalidates it.
+typedef _avlt_node_t * avlt_itr_t;
+
+// Called by avlt_range() for each entry in order.  Returning non-zero
+// stops the scan.
+typedef int (*avlt_range_cb_t)(uint _key, void *_value, void *_arg);
+
 void avlt_init(avlt_t *_avlt);
+void avlt_init_pool(avlt_t *_avlt, size_t _chunk_nodes);
+void avlt_init_shared_pool(avlt_t *_avlt, avlt_t *_owner);
+void avlt_destroy_pool(avlt_t *_avlt);
+void avlt_enable_order_stat(avlt_t *_avlt);
+void avlt_enable_finger(avlt_t *_avlt);
+void avlt_clear(avlt_t *_avlt);
+void avlt_destroy(avlt_t *_avlt);
 void *avlt_search(avlt_t *_avlt, uint _key);
-void avlt_insert(avlt_t *_avlt, uint _key, void *_value);
+void avlt_search_batch(avlt_t *_avlt, const uint *_keys, void **_out,
+		       size_t _n);
+avlt_itr_t avlt_insert(avlt_t *_avlt, uint _key, void *_value);
 void avlt_delete(avlt_t *_avlt, uint _key);
+avlt_itr_t avlt_find(avlt_t *_avlt, uint _key);
+avlt_itr_t avlt_find_or_insert(avlt_t *_avlt, uint _key, bool *_inserted);
+void *avlt_upsert(avlt_t *_avlt, uint _key, void *_value);
+void *avlt_delete_handle(avlt_t *_avlt, avlt_itr_t _handle);
+size_t avlt_erase_range(avlt_t *_avlt, uint _lo, uint _hi);
+void avlt_split(avlt_t *_avlt, uint _key, avlt_t *_left, avlt_t *_right);
+void avlt_join(avlt_t *_left, uint _key, void *_value, avlt_t *_right);
+void avlt_union(avlt_t *_dst, avlt_t *_src);
+void avlt_intersection(avlt_t *_dst, avlt_t *_src);
+void avlt_difference(avlt_t *_dst, avlt_t *_src);
+void avlt_build_sorted(avlt_t *_avlt, const uint *_keys, void **_values,
+		       size_t _n);
+avlt_itr_t avlt_get_itr(avlt_t *_avlt);
+avlt_itr_t avlt_get_last_itr(avlt_t *_avlt);
+avlt_itr_t avlt_lower_bound(avlt_t *_avlt, uint _key);
+avlt_itr_t avlt_iter_next(avlt_itr_t _avlt_itr);
+avlt_itr_t avlt_iter_prev(avlt_itr_t _avlt_itr);
+uint avlt_iter_key(avlt_itr_t _avlt_itr);
+void **avlt_iter_value_slot(avlt_itr_t _avlt_itr);
+void *avlt_iter_value(avlt_itr_t _avlt_itr);
+size_t avlt_range(avlt_t *_avlt, uint _lo, uint _hi,
+		  avlt_range_cb_t _callback, void *_arg);
+size_t avlt_rank(avlt_t *_avlt, uint _key);
+avlt_itr_t avlt_select(avlt_t *_avlt, size_t _k);
+size_t avlt_count_range(avlt_t *_avlt, uint _lo, uint _hi);
 int avlt_validate_order(_avlt_node_t *_node);
 void avlt_print(avlt_t *_avlt);
+void avlt_stats(avlt_t *_avlt, avlt_stats_t *_stats);
+void avlt_stats_reset(avlt_t *_avlt);
+void avlt_stats_print(FILE *_fp, avlt_stats_t *_stats, time_probe_t *_tp);
 
 #endif  // end of #ifndef __C_AVLT_H__
@@ -0,0 +1,119 @@
+/**************************************************
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_avlt_conc.c
+
+AVLTree shared by many lock-free readers and one writer
+at a time.
+
+**************************************************/
+
+#include "c_avlt_conc.h"
+
+#include <assert.h>
+#include <sched.h>
+#include <stdbool.h>
+
+// Spins on an odd sequence before giving the CPU away; the writer may
+// have been preempted inside its critical section.
+#define _SPINS_BEFORE_YIELD (64)
+
+static inline void _cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#endif
+}
+
+// The writer side follows the usual seqlock protocol: make _seq odd,
+// modify, make _seq even again.  The tree code itself does plain stores;
+// the fences keep them inside the odd window as seen by readers.
+static inline void _write_begin(avlt_conc_t *_conc)
+{
+	pthread_mutex_lock(&_conc->_write_lock);
+	__atomic_store_n(&_conc->_seq, _conc->_seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void _write_end(avlt_conc_t *_conc)
+{
+	__atomic_store_n(&_conc->_seq, _conc->_seq + 1, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&_conc->_write_lock);
+}
+
+// Nodes must come from a pool: freed nodes then stay mapped until
+// avlt_conc_destroy(), which is what makes unlocked reads safe.
+void avlt_conc_init(avlt_conc_t *_conc, size_t _chunk_nodes)
+{
+	avlt_init_pool(&_conc->_avlt, _chunk_nodes);
+	pthread_mutex_init(&_conc->_write_lock, NULL);
+	_conc->_seq = 0;
+}
+
+// Must not race with any reader or writer.
+void avlt_conc_destroy(avlt_conc_t *_conc)
+{
+	avlt_destroy_pool(&_conc->_avlt);
+	pthread_mutex_destroy(&_conc->_write_lock);
+}
+
+void *avlt_conc_search(avlt_conc_t *_conc, uint _key)
+{
+	uint64_t _seq;
+	_avlt_node_t *_curr;
+	void *_value;
+	int _depth;
+	int _spins = 0;
+
+	for (;;) {
+		_seq = __atomic_load_n(&_conc->_seq, __ATOMIC_ACQUIRE);
+		if (_seq & 1) {
+			if (++_spins < _SPINS_BEFORE_YIELD) {
+				_cpu_relax();
+			} else {
+				_spins = 0;
+				sched_yield();
+			}
+			continue;
+		}
+
+		_value = NULL;
+		_curr = __atomic_load_n(&_conc->_avlt._root, __ATOMIC_RELAXED);
+		for (_depth = 0; _curr != NULL && _depth < AVLT_CONC_MAX_DEPTH;
+		     _depth++) {
+			uint _node_key = __atomic_load_n(&_curr->_key,
+							 __ATOMIC_RELAXED);
+			if (_node_key > _key) {
+				_curr = __atomic_load_n(&_curr->_left_child,
+							__ATOMIC_RELAXED);
+			} else if (_node_key < _key) {
+				_curr = __atomic_load_n(&_curr->_right_child,
+							__ATOMIC_RELAXED);
+			} else {
+				_value = __atomic_load_n(&_curr->_value,
+							 __ATOMIC_RELAXED);
+				break;
+			}
+		}
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&_conc->_seq, __ATOMIC_RELAXED) == _seq) {
+			return _value;
+		}
+	}
+}
+
+void avlt_conc_insert(avlt_conc_t *_conc, uint _key, void *_value)
+{
+	_write_begin(_conc);
+	avlt_insert(&_conc->_avlt, _key, _value);
+	_write_end(_conc);
+}
+
+void avlt_conc_delete(avlt_conc_t *_conc, uint _key)
+{
+	_write_begin(_conc);
+	avlt_delete(&_conc->_avlt, _key);
+	_write_end(_conc);
+}
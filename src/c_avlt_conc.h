@@ -0,0 +1,45 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_avlt_conc.h
+
+AVLTree shared by many lock-free readers and one writer
+at a time.  Readers are validated with a sequence lock and
+nodes come from the tree's node pool, so a reader racing
+with the writer may look at a recycled node but never at
+unmapped memory; it simply notices the sequence change and
+retries.
+
+\**************************************************/
+
+#ifndef __C_AVLT_CONC_H__
+#define __C_AVLT_CONC_H__
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "c_avlt.h"
+
+// A consistent AVL tree of 2^32 keys is less than 48 levels deep, so a
+// reader that walks further than this is looking at a tree in flux.
+#define AVLT_CONC_MAX_DEPTH (128)
+
+#define AVLT_CONC_CACHE_LINE (64)
+
+typedef struct c_avlt_conc {
+	avlt_t _avlt;
+	pthread_mutex_t _write_lock;
+	// Odd while a writer is modifying _avlt.  Kept on its own cache
+	// line so that readers polling it do not share it with the tree
+	// header the writer keeps updating.
+	uint64_t _seq __attribute__((aligned(AVLT_CONC_CACHE_LINE)));
+} __attribute__((aligned(AVLT_CONC_CACHE_LINE))) avlt_conc_t;
+
+void avlt_conc_init(avlt_conc_t *_conc, size_t _chunk_nodes);
+void avlt_conc_destroy(avlt_conc_t *_conc);
+void *avlt_conc_search(avlt_conc_t *_conc, uint _key);
+void avlt_conc_insert(avlt_conc_t *_conc, uint _key, void *_value);
+void avlt_conc_delete(avlt_conc_t *_conc, uint _key);
+
+#endif  // end of #ifndef __C_AVLT_CONC_H__
@@ -0,0 +1,119 @@
+/**************************************************
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_avlt_frozen.c
+
+Immutable Eytzinger-ordered snapshot of an AVLTree.
+
+**************************************************/
+
+#include "c_avlt_frozen.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <sys/mman.h>
+
+// Copies the tree into a new snapshot.  The tree is left untouched.
+void avlt_freeze(avlt_t *_avlt, avlt_frozen_t *_frozen)
+{
+	size_t _n = _avlt->_size;
+	size_t _k = 1;
+	avlt_itr_t _itr;
+
+	if (posix_memalign((void **) &_frozen->_keys, AVLT_FROZEN_CACHE_LINE,
+			   (_n + 1) * sizeof(uint)) != 0 ||
+	    posix_memalign((void **) &_frozen->_values, AVLT_FROZEN_CACHE_LINE,
+			   (_n + 1) * sizeof(void *)) != 0) {
+		fprintf(stderr, "ERROR: Frozen tree allocation failed!\n");
+		exit(EXIT_FAILURE);
+	}
+	_frozen->_size = _n;
+	_frozen->_map = NULL;
+	_frozen->_map_len = 0;
+	_frozen->_keys[0] = _INIT_VAL;
+	_frozen->_values[0] = NULL;
+	if (_n == 0) {
+		return;
+	}
+
+	// Walk the tree in key order while walking the implicit tree in
+	// order as well: start at its leftmost slot and move to the in-order
+	// successor slot after every entry.
+	while (2 * _k <= _n) {
+		_k = 2 * _k;
+	}
+	for (_itr = avlt_get_itr(_avlt); _itr != NULL;
+	     _itr = avlt_iter_next(_itr)) {
+		_frozen->_keys[_k] = avlt_iter_key(_itr);
+		_frozen->_values[_k] = avlt_iter_value(_itr);
+		if (2 * _k + 1 <= _n) {
+			_k = 2 * _k + 1;
+			while (2 * _k <= _n) {
+				_k = 2 * _k;
+			}
+		} else {
+			// Climb past every right child, then one more.
+			while (_k & 1) {
+				_k >>= 1;
+			}
+			_k >>= 1;
+		}
+	}
+	assert(_k == 0);
+}
+
+void avlt_frozen_destroy(avlt_frozen_t *_frozen)
+{
+	if (_frozen->_map != NULL) {
+		munmap(_frozen->_map, _frozen->_map_len);
+	} else {
+		free(_frozen->_keys);
+		free(_frozen->_values);
+	}
+	_frozen->_map = NULL;
+	_frozen->_map_len = 0;
+	_frozen->_keys = NULL;
+	_frozen->_values = NULL;
+	_frozen->_size = 0;
+}
+
+// Returns the slot of the first key not less than _key, or
+// AVLT_FROZEN_END.  The descent only turns a comparison into the next
+// slot number, so there is nothing for the branch predictor to miss.
+size_t avlt_frozen_lower_bound(avlt_frozen_t *_frozen, uint _key)
+{
+	const uint *_keys = _frozen->_keys;
+	size_t _n = _frozen->_size;
+	size_t _k = 1;
+
+	while (_k <= _n) {
+		__builtin_prefetch(_keys + AVLT_FROZEN_PREFETCH_SLOTS * _k);
+		_k = 2 * _k + (_keys[_k] < _key);
+	}
+	// _k went right at every level below the answer and left once at
+	// the answer: drop the trailing 1 bits and the 0 bit before them.
+	_k >>= __builtin_ffsl(~_k);
+	return _k;
+}
+
+void *avlt_frozen_search(avlt_frozen_t *_frozen, uint _key)
+{
+	size_t _k = avlt_frozen_lower_bound(_frozen, _key);
+	if (_k != AVLT_FROZEN_END && _frozen->_keys[_k] == _key) {
+		return _frozen->_values[_k];
+	}
+	return NULL;
+}
+
+uint avlt_frozen_key(avlt_frozen_t *_frozen, size_t _slot)
+{
+	assert(_slot != AVLT_FROZEN_END && _slot <= _frozen->_size);
+	return _frozen->_keys[_slot];
+}
+
+void *avlt_frozen_value(avlt_frozen_t *_frozen, size_t _slot)
+{
+	assert(_slot != AVLT_FROZEN_END && _slot <= _frozen->_size);
+	return _frozen->_values[_slot];
+}
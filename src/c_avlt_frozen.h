@@ -0,0 +1,47 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_avlt_frozen.h
+
+Immutable snapshot of an AVLTree stored in Eytzinger (BFS)
+order: the children of slot _k are slots 2 * _k and
+2 * _k + 1, so there are no per-entry pointers and the
+search loop is branchless.
+
+\**************************************************/
+
+#ifndef __C_AVLT_FROZEN_H__
+#define __C_AVLT_FROZEN_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "c_avlt.h"
+
+// Slot 0 is unused so that the root is slot 1.  Slot 0 is also what
+// avlt_frozen_lower_bound() returns when there is no such entry.
+#define AVLT_FROZEN_END (0)
+
+// 16 keys fill a 64-byte cache line.  With _keys cache-line aligned,
+// the descendants of slot _k four levels down are slots 16 * _k ..
+// 16 * _k + 15, so one prefetch covers the level four steps ahead.
+#define AVLT_FROZEN_CACHE_LINE (64)
+#define AVLT_FROZEN_PREFETCH_SLOTS (16)
+
+typedef struct c_avlt_frozen {
+	uint *_keys;		// _size + 1 slots
+	void **_values;		// _size + 1 slots
+	size_t _size;
+	void *_map;		// file mapping holding both arrays, or NULL
+	size_t _map_len;
+} avlt_frozen_t;
+
+void avlt_freeze(avlt_t *_avlt, avlt_frozen_t *_frozen);
+void avlt_frozen_destroy(avlt_frozen_t *_frozen);
+void *avlt_frozen_search(avlt_frozen_t *_frozen, uint _key);
+size_t avlt_frozen_lower_bound(avlt_frozen_t *_frozen, uint _key);
+uint avlt_frozen_key(avlt_frozen_t *_frozen, size_t _slot);
+void *avlt_frozen_value(avlt_frozen_t *_frozen, size_t _slot);
+
+#endif  // end of #ifndef __C_AVLT_FROZEN_H__
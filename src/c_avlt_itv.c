@@ -0,0 +1,175 @@
+/**************************************************
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_avlt_itv.c
+
+Interval tree queries.
+
+**************************************************/
+
+#include "c_avlt_itv.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+// Where the entries a query finds go: _callback for single queries,
+// _batch_callback (with _query) for batch queries, or nowhere.
+typedef struct _avlt_itv_sink {
+	avlt_itv_cb_t _callback;
+	avlt_itv_batch_cb_t _batch_callback;
+	size_t _query;
+	void *_arg;
+} _avlt_itv_sink_t;
+
+static inline int _report(_avlt_itv_sink_t *_sink, _avlt_itv_node_t *_node)
+{
+	if (_sink->_callback != NULL) {
+		return _sink->_callback(_node->_key._start, _node->_key._end,
+					_node->_value, _sink->_arg);
+	}
+	if (_sink->_batch_callback != NULL) {
+		return _sink->_batch_callback(_sink->_query,
+					      _node->_key._start,
+					      _node->_key._end, _node->_value,
+					      _sink->_arg);
+	}
+	return 0;
+}
+
+// Reports every entry with _start <= _hi and _end >= _lo in _start
+// order.  The walk goes in order over parent pointers, never enters a
+// subtree whose largest _end is below _lo, and ends at the first entry
+// starting after _hi.  Each reported entry costs at most one descent,
+// so a query visits O((k + 1) log n) nodes for k matches, and O(log n)
+// when nothing matches.
+static size_t _overlap(avlt_itv_t *_itv, uint64_t _lo, uint64_t _hi,
+		       _avlt_itv_sink_t *_sink)
+{
+	_avlt_itv_node_t *_node = _itv->_root;
+	_avlt_itv_node_t *_prev = NULL;
+	_avlt_itv_node_t *_next;
+	size_t _cnt = 0;
+
+	if (_lo > _hi) {
+		return 0;
+	}
+	while (_node != NULL) {
+		bool _visit = false;
+		_next = NULL;
+		if (_prev == _node->_parent) {
+			// Coming down: skip the subtree if it ends too early,
+			// otherwise go left first if anything there can match.
+			if (_node->_aug < _lo) {
+				_next = NULL;
+			} else if (_node->_left_child != NULL &&
+				   _node->_left_child->_aug >= _lo) {
+				_next = _node->_left_child;
+			} else {
+				_visit = true;
+			}
+		} else if (_prev == _node->_left_child) {
+			_visit = true;
+		}
+		if (_visit) {
+			// Left side done: this entry, then the right side.
+			if (_node->_key._start > _hi) {
+				break;
+			}
+			if (_node->_key._end >= _lo) {
+				_cnt++;
+				if (_report(_sink, _node) != 0) {
+					break;
+				}
+			}
+			_next = _node->_right_child;
+			if (_next != NULL && _next->_aug < _lo) {
+				_next = NULL;
+			}
+		}
+		_prev = _node;
+		_node = (_next != NULL) ? _next : _node->_parent;
+	}
+	return _cnt;
+}
+
+void avlt_itv_init(avlt_itv_t *_itv)
+{
+	_avlt_itv_init(_itv);
+}
+
+void avlt_itv_clear(avlt_itv_t *_itv)
+{
+	_avlt_itv_clear(_itv);
+}
+
+void avlt_itv_insert(avlt_itv_t *_itv, uint64_t _start, uint64_t _end,
+		     void *_value)
+{
+	avlt_itv_key_t _key = { _start, _end, (uintptr_t) _value };
+
+	if (_start > _end) {
+		fprintf(stderr, "ERROR: Interval [%llu, %llu] ends before "
+			"it starts!\n", (unsigned long long) _start,
+			(unsigned long long) _end);
+		assert(false);
+	}
+	_avlt_itv_insert(_itv, _key, _value);
+}
+
+void avlt_itv_delete(avlt_itv_t *_itv, uint64_t _start, uint64_t _end,
+		     void *_value)
+{
+	avlt_itv_key_t _key = { _start, _end, (uintptr_t) _value };
+	_avlt_itv_delete(_itv, _key);
+}
+
+// Calls _callback on every entry containing _point and returns how
+// many entries were visited.  _callback may be NULL to just count.
+size_t avlt_itv_stab(avlt_itv_t *_itv, uint64_t _point,
+		     avlt_itv_cb_t _callback, void *_arg)
+{
+	_avlt_itv_sink_t _sink = { _callback, NULL, 0, _arg };
+	return _overlap(_itv, _point, _point, &_sink);
+}
+
+// Calls _callback on every entry overlapping [_lo, _hi] and returns how
+// many entries were visited.  _callback may be NULL to just count.
+size_t avlt_itv_overlap(avlt_itv_t *_itv, uint64_t _lo, uint64_t _hi,
+			avlt_itv_cb_t _callback, void *_arg)
+{
+	_avlt_itv_sink_t _sink = { _callback, NULL, 0, _arg };
+	return _overlap(_itv, _lo, _hi, &_sink);
+}
+
+// Runs avlt_itv_stab() for each of _n points, passing the index of the
+// point to _callback, and returns the total number of matches.
+size_t avlt_itv_stab_batch(avlt_itv_t *_itv, const uint64_t *_points,
+			   size_t _n, avlt_itv_batch_cb_t _callback,
+			   void *_arg)
+{
+	_avlt_itv_sink_t _sink = { NULL, _callback, 0, _arg };
+	size_t _cnt = 0;
+
+	for (_sink._query = 0; _sink._query < _n; _sink._query++) {
+		_cnt += _overlap(_itv, _points[_sink._query],
+				 _points[_sink._query], &_sink);
+	}
+	return _cnt;
+}
+
+// Runs avlt_itv_overlap() for each [_lo[i], _hi[i]], passing i to
+// _callback, and returns the total number of matches.
+size_t avlt_itv_overlap_batch(avlt_itv_t *_itv, const uint64_t *_lo,
+			      const uint64_t *_hi, size_t _n,
+			      avlt_itv_batch_cb_t _callback, void *_arg)
+{
+	_avlt_itv_sink_t _sink = { NULL, _callback, 0, _arg };
+	size_t _cnt = 0;
+
+	for (_sink._query = 0; _sink._query < _n; _sink._query++) {
+		_cnt += _overlap(_itv, _lo[_sink._query], _hi[_sink._query],
+				 &_sink);
+	}
+	return _cnt;
+}
@@ -0,0 +1,77 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_avlt_itv.h
+
+Interval tree built on c_avlt_tmpl.h.  Entries are closed
+ranges [_start, _end] ordered by _start, and every node keeps
+the largest _end in its subtree, so overlap queries skip each
+subtree that ends before the query begins.
+
+\**************************************************/
+
+#ifndef __C_AVLT_ITV_H__
+#define __C_AVLT_ITV_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Entries with the same range are told apart by their value, so the
+// same range can be stored once per value.
+typedef struct avlt_itv_key {
+	uint64_t _start;
+	uint64_t _end;
+	uintptr_t _tag;		// the entry's value
+} avlt_itv_key_t;
+
+static inline bool avlt_itv_key_less(avlt_itv_key_t _a, avlt_itv_key_t _b)
+{
+	if (_a._start != _b._start) {
+		return _a._start < _b._start;
+	}
+	if (_a._end != _b._end) {
+		return _a._end < _b._end;
+	}
+	return _a._tag < _b._tag;
+}
+
+#define AVLT_TMPL_NAME _avlt_itv
+#define AVLT_TMPL_PRIV_NAME _avlt_itv
+#define AVLT_TMPL_KEY_T avlt_itv_key_t
+#define AVLT_TMPL_LESS(_a, _b) avlt_itv_key_less(_a, _b)
+#define AVLT_TMPL_AUG_T uint64_t
+#define AVLT_TMPL_AUG_LEAF(_key) ((_key)._end)
+#define AVLT_TMPL_AUG_COMBINE(_a, _b) (((_a) > (_b)) ? (_a) : (_b))
+#include "c_avlt_tmpl.h"
+
+typedef _avlt_itv_t avlt_itv_t;
+
+// Called for each entry a query finds.  Returning non-zero stops the
+// query.
+typedef int (*avlt_itv_cb_t)(uint64_t _start, uint64_t _end, void *_value,
+			     void *_arg);
+
+// Same for batch queries, with the index of the query in the batch.
+typedef int (*avlt_itv_batch_cb_t)(size_t _query, uint64_t _start,
+				   uint64_t _end, void *_value, void *_arg);
+
+void avlt_itv_init(avlt_itv_t *_itv);
+void avlt_itv_clear(avlt_itv_t *_itv);
+void avlt_itv_insert(avlt_itv_t *_itv, uint64_t _start, uint64_t _end,
+		     void *_value);
+void avlt_itv_delete(avlt_itv_t *_itv, uint64_t _start, uint64_t _end,
+		     void *_value);
+size_t avlt_itv_stab(avlt_itv_t *_itv, uint64_t _point,
+		     avlt_itv_cb_t _callback, void *_arg);
+size_t avlt_itv_overlap(avlt_itv_t *_itv, uint64_t _lo, uint64_t _hi,
+			avlt_itv_cb_t _callback, void *_arg);
+size_t avlt_itv_stab_batch(avlt_itv_t *_itv, const uint64_t *_points,
+			   size_t _n, avlt_itv_batch_cb_t _callback,
+			   void *_arg);
+size_t avlt_itv_overlap_batch(avlt_itv_t *_itv, const uint64_t *_lo,
+			      const uint64_t *_hi, size_t _n,
+			      avlt_itv_batch_cb_t _callback, void *_arg);
+
+#endif  // end of #ifndef __C_AVLT_ITV_H__
@@ -0,0 +1,209 @@
+/**************************************************
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_avlt_mmap.c
+
+Saving an AVLTree index and mapping it back for queries.
+
+**************************************************/
+
+#include "c_avlt_mmap.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define _FNV_OFFSET (0xcbf29ce484222325ULL)
+#define _FNV_PRIME (0x100000001b3ULL)
+
+// FNV-1a over 64-bit words.  _len must be a multiple of 8.
+static uint64_t _checksum(const void *_data, size_t _len)
+{
+	const uint64_t *_words = (const uint64_t *) _data;
+	uint64_t _hash = _FNV_OFFSET;
+	size_t _i;
+
+	assert(_len % sizeof(uint64_t) == 0);
+	for (_i = 0; _i < _len / sizeof(uint64_t); _i++) {
+		_hash = (_hash ^ _words[_i]) * _FNV_PRIME;
+	}
+	return _hash ^ (_hash >> 32);
+}
+
+static uint64_t _header_checksum(const _avlt_mmap_header_t *_header)
+{
+	return _checksum(_header,
+			 offsetof(_avlt_mmap_header_t, _header_checksum));
+}
+
+static uint64_t _round_up(uint64_t _off)
+{
+	return (_off + AVLT_FROZEN_CACHE_LINE - 1) &
+	       ~(uint64_t) (AVLT_FROZEN_CACHE_LINE - 1);
+}
+
+// Fills in every header field but the checksums for _n entries.
+static void _layout(_avlt_mmap_header_t *_header, size_t _n)
+{
+	memset(_header, 0, sizeof(*_header));
+	strcpy(_header->_magic, AVLT_MMAP_MAGIC);
+	_header->_version = AVLT_MMAP_VERSION;
+	_header->_byte_order = AVLT_MMAP_BYTE_ORDER;
+	_header->_size = _n;
+	_header->_keys_offset = _round_up(sizeof(_avlt_mmap_header_t));
+	_header->_values_offset = _round_up(_header->_keys_offset +
+					    (_n + 1) * sizeof(uint32_t));
+	_header->_file_size = _header->_values_offset +
+			      (_n + 1) * sizeof(uint64_t);
+}
+
+// Writes the tree to _path in the layout above.  Returns 0 on success
+// and -1 if the file could not be written.
+int avlt_save(avlt_t *_avlt, const char *_path)
+{
+	_avlt_mmap_header_t _header;
+	avlt_frozen_t _frozen;
+	unsigned char *_payload;
+	uint64_t *_values;
+	size_t _payload_len;
+	size_t _i;
+	FILE *_fp;
+	int _ret = 0;
+
+	avlt_freeze(_avlt, &_frozen);
+	_layout(&_header, _frozen._size);
+
+	// Stage the whole payload so it can be checksummed before writing.
+	_payload_len = _header._file_size - _header._keys_offset;
+	_payload = (unsigned char *) calloc(1, _payload_len);
+	if (_payload == NULL) {
+		fprintf(stderr, "ERROR: Index payload allocation failed!\n");
+		exit(EXIT_FAILURE);
+	}
+	memcpy(_payload, _frozen._keys, (_frozen._size + 1) * sizeof(uint));
+	_values = (uint64_t *) (_payload + (_header._values_offset -
+					    _header._keys_offset));
+	for (_i = 0; _i <= _frozen._size; _i++) {
+		_values[_i] = (uint64_t) (uintptr_t) _frozen._values[_i];
+	}
+	_header._payload_checksum = _checksum(_payload, _payload_len);
+	_header._header_checksum = _header_checksum(&_header);
+	avlt_frozen_destroy(&_frozen);
+
+	_fp = fopen(_path, "wb");
+	if (_fp == NULL) {
+		fprintf(stderr, "ERROR: Cannot create index file %s!\n", _path);
+		free(_payload);
+		return -1;
+	}
+	if (fwrite(&_header, sizeof(_header), 1, _fp) != 1 ||
+	    fseek(_fp, (long) _header._keys_offset, SEEK_SET) != 0 ||
+	    fwrite(_payload, 1, _payload_len, _fp) != _payload_len) {
+		fprintf(stderr, "ERROR: Cannot write index file %s!\n", _path);
+		_ret = -1;
+	}
+	if (fclose(_fp) != 0) {
+		_ret = -1;
+	}
+	free(_payload);
+	return _ret;
+}
+
+// Checks everything about the mapping that does not depend on the
+// payload size, so opening stays O(1).
+static int _check_header(const _avlt_mmap_header_t *_header,
+			 size_t _file_size)
+{
+	_avlt_mmap_header_t _expect;
+
+	if (memcmp(_header->_magic, AVLT_MMAP_MAGIC,
+		   sizeof(AVLT_MMAP_MAGIC)) != 0) {
+		fprintf(stderr, "ERROR: Not an index file!\n");
+		return -1;
+	}
+	if (_header->_byte_order != AVLT_MMAP_BYTE_ORDER ||
+	    _header->_version != AVLT_MMAP_VERSION) {
+		fprintf(stderr, "ERROR: Unsupported index version (%u) or "
+			"byte order!\n", _header->_version);
+		return -1;
+	}
+	if (_header->_header_checksum != _header_checksum(_header)) {
+		fprintf(stderr, "ERROR: Index header checksum mismatch!\n");
+		return -1;
+	}
+	_layout(&_expect, _header->_size);
+	if (_header->_keys_offset != _expect._keys_offset ||
+	    _header->_values_offset != _expect._values_offset ||
+	    _header->_file_size != _expect._file_size ||
+	    _header->_file_size != _file_size) {
+		fprintf(stderr, "ERROR: Index file is truncated or has a "
+			"bad layout!\n");
+		return -1;
+	}
+	return 0;
+}
+
+// Maps the index at _path read-only into _frozen, which then works with
+// every avlt_frozen_*() call; avlt_frozen_destroy() unmaps it.  Nothing
+// is read up front beyond the header unless _flags has
+// AVLT_MMAP_VERIFY, which checksums the whole payload.  Returns 0 on
+// success and -1 if the file is missing or fails a check.
+int avlt_open_mmap(const char *_path, avlt_frozen_t *_frozen, uint _flags)
+{
+	const _avlt_mmap_header_t *_header;
+	unsigned char *_map;
+	struct stat _st;
+	int _fd;
+
+	// The value array is handed out as void *[] in place.
+	if (sizeof(void *) != sizeof(uint64_t)) {
+		fprintf(stderr, "ERROR: Index files need 64-bit pointers!\n");
+		return -1;
+	}
+
+	_fd = open(_path, O_RDONLY);
+	if (_fd < 0) {
+		fprintf(stderr, "ERROR: Cannot open index file %s!\n", _path);
+		return -1;
+	}
+	if (fstat(_fd, &_st) != 0 ||
+	    (size_t) _st.st_size < sizeof(_avlt_mmap_header_t)) {
+		fprintf(stderr, "ERROR: Index file %s is too short!\n", _path);
+		close(_fd);
+		return -1;
+	}
+	_map = (unsigned char *) mmap(NULL, _st.st_size, PROT_READ,
+				      MAP_SHARED, _fd, 0);
+	close(_fd);
+	if (_map == MAP_FAILED) {
+		fprintf(stderr, "ERROR: Cannot map index file %s!\n", _path);
+		return -1;
+	}
+
+	_header = (const _avlt_mmap_header_t *) _map;
+	if (_check_header(_header, _st.st_size) != 0) {
+		munmap(_map, _st.st_size);
+		return -1;
+	}
+	if ((_flags & AVLT_MMAP_VERIFY) &&
+	    _checksum(_map + _header->_keys_offset,
+		      _header->_file_size - _header->_keys_offset) !=
+	    _header->_payload_checksum) {
+		fprintf(stderr, "ERROR: Index payload checksum mismatch!\n");
+		munmap(_map, _st.st_size);
+		return -1;
+	}
+
+	_frozen->_keys = (uint *) (_map + _header->_keys_offset);
+	_frozen->_values = (void **) (_map + _header->_values_offset);
+	_frozen->_size = _header->_size;
+	_frozen->_map = _map;
+	_frozen->_map_len = _st.st_size;
+	return 0;
+}
@@ -0,0 +1,53 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_avlt_mmap.h
+
+On-disk AVLTree index that is queried in place.  The file
+holds the Eytzinger layout of c_avlt_frozen.h, where a slot
+number is all a child link needs, so there are no pointers to
+fix up: avlt_open_mmap() maps the file read-only and hands
+back an avlt_frozen_t over the mapping.
+
+Values are stored as 64-bit integers, so they should be
+record numbers or file offsets cast to void *, not pointers.
+
+\**************************************************/
+
+#ifndef __C_AVLT_MMAP_H__
+#define __C_AVLT_MMAP_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "c_avlt.h"
+#include "c_avlt_frozen.h"
+
+#define AVLT_MMAP_MAGIC "AVLTIDX"	// 7 characters and the NUL
+#define AVLT_MMAP_VERSION (1)
+#define AVLT_MMAP_BYTE_ORDER (0x01020304)
+
+// avlt_open_mmap() flags
+#define AVLT_MMAP_VERIFY (0x1)	// also check the payload checksum
+
+// File layout: this header, then _size + 1 uint32_t keys starting at
+// _keys_offset, then _size + 1 uint64_t values starting at
+// _values_offset.  Both arrays are slot-indexed like avlt_frozen_t and
+// start on a cache line.  All fields are in the writer's byte order.
+typedef struct _avlt_mmap_header {
+	char _magic[8];
+	uint32_t _version;
+	uint32_t _byte_order;
+	uint64_t _size;
+	uint64_t _keys_offset;
+	uint64_t _values_offset;
+	uint64_t _file_size;
+	uint64_t _payload_checksum;	// bytes _keys_offset .. _file_size
+	uint64_t _header_checksum;	// every field above
+} _avlt_mmap_header_t;
+
+int avlt_save(avlt_t *_avlt, const char *_path);
+int avlt_open_mmap(const char *_path, avlt_frozen_t *_frozen, uint _flags);
+
+#endif  // end of #ifndef __C_AVLT_MMAP_H__
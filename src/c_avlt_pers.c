@@ -0,0 +1,294 @@
+/**************************************************
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_avlt_pers.c
+
+Persistent (copy-on-write) AVLTree implementation.
+
+**************************************************/
+
+#include "c_avlt_pers.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+static _avlt_pers_node_t *_create_new_node(uint _key, void *_value)
+{
+	_avlt_pers_node_t *_node =
+		(_avlt_pers_node_t *) malloc(sizeof(_avlt_pers_node_t));
+	if (_node == NULL) {
+		fprintf(stderr, "ERROR: Node allocation failed!\n");
+		exit(EXIT_FAILURE);
+	}
+	_node->_key = _key;
+	_node->_refs = 1;
+	_node->_value = _value;
+	_node->_left_child = NULL;
+	_node->_right_child = NULL;
+	_node->_height = 1;
+	return _node;
+}
+
+static void _hold(_avlt_pers_node_t *_node)
+{
+	if (_node != NULL) {
+		__atomic_add_fetch(&_node->_refs, 1, __ATOMIC_RELAXED);
+	}
+}
+
+// Drops one reference to _node and frees whatever is no longer
+// reachable.  Dead nodes are chained through _left_child while their
+// right subtrees wait to be dropped, so no stack is needed.
+static void _drop(_avlt_pers_node_t *_node)
+{
+	_avlt_pers_node_t *_dead = NULL;
+	_avlt_pers_node_t *_next;
+
+	for (;;) {
+		while (_node != NULL &&
+		       __atomic_sub_fetch(&_node->_refs, 1,
+					  __ATOMIC_ACQ_REL) == 0) {
+			_next = _node->_left_child;
+			_node->_left_child = _dead;
+			_dead = _node;
+			_node = _next;
+		}
+		if (_dead == NULL) {
+			break;
+		}
+		_node = _dead->_right_child;
+		_next = _dead->_left_child;
+		free(_dead);
+		_dead = _next;
+	}
+}
+
+// Returns a node the caller may modify in place, standing in for _node.
+// The caller's reference to _node moves to the result: a node only this
+// version reaches is returned as is, a shared one is copied and the
+// copy takes new references on its children.
+static _avlt_pers_node_t *_writable(_avlt_pers_node_t *_node)
+{
+	_avlt_pers_node_t *_copy;
+
+	if (__atomic_load_n(&_node->_refs, __ATOMIC_ACQUIRE) == 1) {
+		return _node;
+	}
+	_copy = _create_new_node(_node->_key, _node->_value);
+	_copy->_left_child = _node->_left_child;
+	_copy->_right_child = _node->_right_child;
+	_copy->_height = _node->_height;
+	_hold(_copy->_left_child);
+	_hold(_copy->_right_child);
+	_drop(_node);
+	return _copy;
+}
+
+static int _height(_avlt_pers_node_t *_node)
+{
+	return (_node == NULL) ? 0 : _node->_height;
+}
+
+static void _update_height(_avlt_pers_node_t *_node)
+{
+	int _left = _height(_node->_left_child);
+	int _right = _height(_node->_right_child);
+	_node->_height = ((_left > _right) ? _left : _right) + 1;
+}
+
+// Both rotations take a writable node and return the writable root of
+// the rotated subtree, which inherits the caller's reference.
+static _avlt_pers_node_t *_rotate_right(_avlt_pers_node_t *_node)
+{
+	_avlt_pers_node_t *_left = _writable(_node->_left_child);
+
+	_node->_left_child = _left->_right_child;
+	_left->_right_child = _node;
+	_update_height(_node);
+	_update_height(_left);
+	return _left;
+}
+
+static _avlt_pers_node_t *_rotate_left(_avlt_pers_node_t *_node)
+{
+	_avlt_pers_node_t *_right = _writable(_node->_right_child);
+
+	_node->_right_child = _right->_left_child;
+	_right->_left_child = _node;
+	_update_height(_node);
+	_update_height(_right);
+	return _right;
+}
+
+static _avlt_pers_node_t *_rebalance(_avlt_pers_node_t *_node)
+{
+	int _balance = _height(_node->_left_child) -
+		       _height(_node->_right_child);
+
+	if (_balance == _LEFT2X) {
+		_avlt_pers_node_t *_left = _node->_left_child;
+		if (_height(_left->_left_child) <
+		    _height(_left->_right_child)) {
+			_node->_left_child = _rotate_left(_writable(_left));
+		}
+		return _rotate_right(_node);
+	}
+	if (_balance == _RIGHT2X) {
+		_avlt_pers_node_t *_right = _node->_right_child;
+		if (_height(_right->_right_child) <
+		    _height(_right->_left_child)) {
+			_node->_right_child = _rotate_right(_writable(_right));
+		}
+		return _rotate_left(_node);
+	}
+	_update_height(_node);
+	return _node;
+}
+
+// _insert() and _delete() consume the caller's reference to _node and
+// return the new subtree root with that reference.  The key is known to
+// be absent (resp. present), so every node on the path gets rewritten.
+static _avlt_pers_node_t *_insert(_avlt_pers_node_t *_node, uint _key,
+				  void *_value)
+{
+	if (_node == NULL) {
+		return _create_new_node(_key, _value);
+	}
+	_node = _writable(_node);
+	if (_key < _node->_key) {
+		_node->_left_child = _insert(_node->_left_child, _key, _value);
+	} else {
+		_node->_right_child = _insert(_node->_right_child, _key,
+					      _value);
+	}
+	return _rebalance(_node);
+}
+
+static _avlt_pers_node_t *_delete(_avlt_pers_node_t *_node, uint _key)
+{
+	_avlt_pers_node_t *_child;
+
+	_node = _writable(_node);
+	if (_key < _node->_key) {
+		_node->_left_child = _delete(_node->_left_child, _key);
+	} else if (_key > _node->_key) {
+		_node->_right_child = _delete(_node->_right_child, _key);
+	} else if (_node->_left_child == NULL ||
+		   _node->_right_child == NULL) {
+		// Hand the only child's reference up and free _node.
+		_child = (_node->_left_child != NULL) ?
+			 _node->_left_child : _node->_right_child;
+		_node->_left_child = NULL;
+		_node->_right_child = NULL;
+		_drop(_node);
+		return _child;
+	} else {
+		// Take over the successor's entry and delete it below.
+		_child = _node->_right_child;
+		while (_child->_left_child != NULL) {
+			_child = _child->_left_child;
+		}
+		_node->_key = _child->_key;
+		_node->_value = _child->_value;
+		_node->_right_child = _delete(_node->_right_child,
+					      _child->_key);
+	}
+	return _rebalance(_node);
+}
+
+static _avlt_pers_node_t *_search(_avlt_pers_node_t *_node, uint _key)
+{
+	while (_node != NULL && _node->_key != _key) {
+		_node = (_key < _node->_key) ?
+			_node->_left_child : _node->_right_child;
+	}
+	return _node;
+}
+
+void avlt_pers_init(avlt_pers_t *_avlt)
+{
+	_avlt->_root = NULL;
+	_avlt->_size = 0;
+}
+
+// Makes _snapshot a new version sharing every node with _avlt.  Either
+// one can be modified afterwards without the other seeing it.  O(1).
+void avlt_pers_snapshot(avlt_pers_t *_avlt, avlt_pers_t *_snapshot)
+{
+	_hold(_avlt->_root);
+	_snapshot->_root = _avlt->_root;
+	_snapshot->_size = _avlt->_size;
+}
+
+// Drops the version and frees the nodes no other version shares.
+void avlt_pers_release(avlt_pers_t *_avlt)
+{
+	_drop(_avlt->_root);
+	_avlt->_root = NULL;
+	_avlt->_size = 0;
+}
+
+void *avlt_pers_search(avlt_pers_t *_avlt, uint _key)
+{
+	_avlt_pers_node_t *_node = _search(_avlt->_root, _key);
+	return (_node == NULL) ? NULL : _node->_value;
+}
+
+void avlt_pers_insert(avlt_pers_t *_avlt, uint _key, void *_value)
+{
+	if (_search(_avlt->_root, _key) != NULL) {
+		fprintf(stderr, "ERROR: Redundant key (%u) value "
+			"inserted!\n", _key);
+		assert(false);
+		return;
+	}
+	_avlt->_root = _insert(_avlt->_root, _key, _value);
+	_avlt->_size++;
+}
+
+void avlt_pers_delete(avlt_pers_t *_avlt, uint _key)
+{
+	assert(_search(_avlt->_root, _key) != NULL);
+
+	_avlt->_root = _delete(_avlt->_root, _key);
+	_avlt->_size--;
+}
+
+// Calls _callback on every entry with _lo <= key <= _hi in key order and
+// returns how many entries were visited.
+size_t avlt_pers_range(avlt_pers_t *_avlt, uint _lo, uint _hi,
+		       avlt_range_cb_t _callback, void *_arg)
+{
+	_avlt_pers_node_t *_stack[AVLT_PERS_MAX_DEPTH];
+	_avlt_pers_node_t *_node = _avlt->_root;
+	int _depth = 0;
+	size_t _cnt = 0;
+
+	for (;;) {
+		// Stack the path down to the smallest key >= _lo that is left.
+		while (_node != NULL) {
+			if (_node->_key < _lo) {
+				_node = _node->_right_child;
+				continue;
+			}
+			assert(_depth < AVLT_PERS_MAX_DEPTH);
+			_stack[_depth++] = _node;
+			_node = _node->_left_child;
+		}
+		if (_depth == 0) {
+			break;
+		}
+		_node = _stack[--_depth];
+		if (_node->_key > _hi) {
+			break;
+		}
+		_cnt++;
+		if (_callback(_node->_key, _node->_value, _arg) != 0) {
+			break;
+		}
+		_node = _node->_right_child;
+	}
+	return _cnt;
+}
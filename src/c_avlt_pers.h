@@ -0,0 +1,55 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_avlt_pers.h
+
+Persistent (copy-on-write) AVLTree.  A snapshot shares every
+node with the tree it was taken from and costs O(1); an insert
+or delete afterwards copies only the nodes on its path and
+leaves the other versions untouched.  Nodes are reference
+counted, so they have no parent pointer and the balance is
+kept as a height.
+
+A version must be written by one thread at a time, but its
+snapshots can be searched, scanned and released from any
+thread once handed over.
+
+\**************************************************/
+
+#ifndef __C_AVLT_PERS_H__
+#define __C_AVLT_PERS_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "c_avlt.h"
+
+// Deepest path avlt_pers_range() can follow.  An AVL tree of 2^32 keys
+// is at most 46 levels tall.
+#define AVLT_PERS_MAX_DEPTH (64)
+
+typedef struct _avlt_pers_node {
+	uint _key;
+	uint _refs;		// versions and parent nodes pointing here
+	void *_value;
+	struct _avlt_pers_node *_left_child;
+	struct _avlt_pers_node *_right_child;
+	int _height;
+} _avlt_pers_node_t;
+
+typedef struct c_avlt_pers {
+	_avlt_pers_node_t *_root;	// holds one reference
+	size_t _size;
+} avlt_pers_t;
+
+void avlt_pers_init(avlt_pers_t *_avlt);
+void avlt_pers_snapshot(avlt_pers_t *_avlt, avlt_pers_t *_snapshot);
+void avlt_pers_release(avlt_pers_t *_avlt);
+void *avlt_pers_search(avlt_pers_t *_avlt, uint _key);
+void avlt_pers_insert(avlt_pers_t *_avlt, uint _key, void *_value);
+void avlt_pers_delete(avlt_pers_t *_avlt, uint _key);
+size_t avlt_pers_range(avlt_pers_t *_avlt, uint _lo, uint _hi,
+		       avlt_range_cb_t _callback, void *_arg);
+
+#endif  // end of #ifndef __C_AVLT_PERS_H__
@@ -0,0 +1,304 @@
+/**************************************************
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_avlt_shard.c
+
+Sharded AVLTree map.
+
+**************************************************/
+
+#include "c_avlt_shard.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Multiplicative hash mapped onto [0, _num_shards) by multiply-shift,
+// so the shard count does not need to be a power of two.
+static inline size_t _shard_of(avlt_shard_t *_avlt_shard, uint _key)
+{
+	uint _hash = _key * 2654435761U;
+	return (size_t) (((uint64_t) _hash * _avlt_shard->_num_shards) >> 32);
+}
+
+void avlt_shard_init(avlt_shard_t *_avlt_shard, size_t _num_shards)
+{
+	size_t _i;
+	assert(_num_shards > 0);
+	if (posix_memalign((void **) &_avlt_shard->_shards,
+			   AVLT_SHARD_CACHE_LINE,
+			   _num_shards * sizeof(_avlt_shard_t)) != 0) {
+		fprintf(stderr, "ERROR: Shard allocation failed!\n");
+		exit(EXIT_FAILURE);
+	}
+	_avlt_shard->_num_shards = _num_shards;
+	for (_i = 0; _i < _num_shards; _i++) {
+		pthread_mutex_init(&_avlt_shard->_shards[_i]._lock, NULL);
+		avlt_init_pool(&_avlt_shard->_shards[_i]._avlt, 0);
+	}
+}
+
+void avlt_shard_destroy(avlt_shard_t *_avlt_shard)
+{
+	size_t _i;
+	for (_i = 0; _i < _avlt_shard->_num_shards; _i++) {
+		avlt_destroy_pool(&_avlt_shard->_shards[_i]._avlt);
+		pthread_mutex_destroy(&_avlt_shard->_shards[_i]._lock);
+	}
+	free(_avlt_shard->_shards);
+	_avlt_shard->_shards = NULL;
+	_avlt_shard->_num_shards = 0;
+}
+
+void *avlt_shard_search(avlt_shard_t *_avlt_shard, uint _key)
+{
+	_avlt_shard_t *_shard = &_avlt_shard->_shards[_shard_of(_avlt_shard,
+								 _key)];
+	void *_value;
+	pthread_mutex_lock(&_shard->_lock);
+	_value = avlt_search(&_shard->_avlt, _key);
+	pthread_mutex_unlock(&_shard->_lock);
+	return _value;
+}
+
+void avlt_shard_insert(avlt_shard_t *_avlt_shard, uint _key, void *_value)
+{
+	_avlt_shard_t *_shard = &_avlt_shard->_shards[_shard_of(_avlt_shard,
+								 _key)];
+	pthread_mutex_lock(&_shard->_lock);
+	avlt_insert(&_shard->_avlt, _key, _value);
+	pthread_mutex_unlock(&_shard->_lock);
+}
+
+void avlt_shard_delete(avlt_shard_t *_avlt_shard, uint _key)
+{
+	_avlt_shard_t *_shard = &_avlt_shard->_shards[_shard_of(_avlt_shard,
+								 _key)];
+	pthread_mutex_lock(&_shard->_lock);
+	avlt_delete(&_shard->_avlt, _key);
+	pthread_mutex_unlock(&_shard->_lock);
+}
+
+// Not a snapshot: shards are counted one after another.
+size_t avlt_shard_size(avlt_shard_t *_avlt_shard)
+{
+	size_t _i;
+	size_t _size = 0;
+	for (_i = 0; _i < _avlt_shard->_num_shards; _i++) {
+		pthread_mutex_lock(&_avlt_shard->_shards[_i]._lock);
+		_size += _avlt_shard->_shards[_i]._avlt._size;
+		pthread_mutex_unlock(&_avlt_shard->_shards[_i]._lock);
+	}
+	return _size;
+}
+
+// Counting sort of the batch by shard.  On return _order lists the
+// positions of the batch grouped by shard, and the keys of shard _i are
+// _order[_start[_i]] .. _order[_start[_i + 1] - 1].
+static void _group_by_shard(avlt_shard_t *_avlt_shard, const uint *_keys,
+			    size_t _n, size_t *_order, size_t *_start)
+{
+	size_t _i;
+	size_t _num_shards = _avlt_shard->_num_shards;
+	size_t *_fill = _start + _num_shards + 1;
+
+	for (_i = 0; _i <= _num_shards; _i++) {
+		_start[_i] = 0;
+	}
+	for (_i = 0; _i < _n; _i++) {
+		_start[_shard_of(_avlt_shard, _keys[_i]) + 1]++;
+	}
+	for (_i = 0; _i < _num_shards; _i++) {
+		_start[_i + 1] += _start[_i];
+		_fill[_i] = _start[_i];
+	}
+	for (_i = 0; _i < _n; _i++) {
+		_order[_fill[_shard_of(_avlt_shard, _keys[_i])]++] = _i;
+	}
+}
+
+// Scratch space for _group_by_shard(): _n positions plus two arrays of
+// shard offsets.
+static size_t *_alloc_order(avlt_shard_t *_avlt_shard, size_t _n)
+{
+	size_t *_order = (size_t *) malloc((_n + 2 * _avlt_shard->_num_shards
+					    + 1) * sizeof(size_t));
+	assert(_order != NULL);
+	return _order;
+}
+
+// Each shard lock is taken once per batch and the shard's keys are
+// looked up together with avlt_search_batch().  An empty batch returns
+// before allocating, since malloc(0) may return NULL.
+void avlt_shard_search_batch(avlt_shard_t *_avlt_shard, const uint *_keys,
+			     void **_out, size_t _n)
+{
+	size_t *_order;
+	size_t *_start;
+	uint *_shard_keys;
+	void **_shard_out;
+	size_t _s;
+	size_t _i;
+
+	if (_n == 0) {
+		return;
+	}
+	_order = _alloc_order(_avlt_shard, _n);
+	_start = _order + _n;
+	_shard_keys = (uint *) malloc(_n * sizeof(uint));
+	_shard_out = (void **) malloc(_n * sizeof(void *));
+	assert(_shard_keys != NULL && _shard_out != NULL);
+	_group_by_shard(_avlt_shard, _keys, _n, _order, _start);
+	for (_i = 0; _i < _n; _i++) {
+		_shard_keys[_i] = _keys[_order[_i]];
+	}
+	for (_s = 0; _s < _avlt_shard->_num_shards; _s++) {
+		_avlt_shard_t *_shard = &_avlt_shard->_shards[_s];
+		if (_start[_s] == _start[_s + 1]) {
+			continue;
+		}
+		pthread_mutex_lock(&_shard->_lock);
+		avlt_search_batch(&_shard->_avlt, _shard_keys + _start[_s],
+				  _shard_out + _start[_s],
+				  _start[_s + 1] - _start[_s]);
+		pthread_mutex_unlock(&_shard->_lock);
+	}
+	for (_i = 0; _i < _n; _i++) {
+		_out[_order[_i]] = _shard_out[_i];
+	}
+
+	free(_shard_out);
+	free(_shard_keys);
+	free(_order);
+}
+
+void avlt_shard_insert_batch(avlt_shard_t *_avlt_shard, const uint *_keys,
+			     void **_values, size_t _n)
+{
+	size_t *_order;
+	size_t *_start;
+	size_t _s;
+	size_t _i;
+
+	if (_n == 0) {
+		return;
+	}
+	_order = _alloc_order(_avlt_shard, _n);
+	_start = _order + _n;
+	_group_by_shard(_avlt_shard, _keys, _n, _order, _start);
+	for (_s = 0; _s < _avlt_shard->_num_shards; _s++) {
+		_avlt_shard_t *_shard = &_avlt_shard->_shards[_s];
+		if (_start[_s] == _start[_s + 1]) {
+			continue;
+		}
+		pthread_mutex_lock(&_shard->_lock);
+		for (_i = _start[_s]; _i < _start[_s + 1]; _i++) {
+			avlt_insert(&_shard->_avlt, _keys[_order[_i]],
+				    _values[_order[_i]]);
+		}
+		pthread_mutex_unlock(&_shard->_lock);
+	}
+	free(_order);
+}
+
+void avlt_shard_delete_batch(avlt_shard_t *_avlt_shard, const uint *_keys,
+			     size_t _n)
+{
+	size_t *_order;
+	size_t *_start;
+	size_t _s;
+	size_t _i;
+
+	if (_n == 0) {
+		return;
+	}
+	_order = _alloc_order(_avlt_shard, _n);
+	_start = _order + _n;
+	_group_by_shard(_avlt_shard, _keys, _n, _order, _start);
+	for (_s = 0; _s < _avlt_shard->_num_shards; _s++) {
+		_avlt_shard_t *_shard = &_avlt_shard->_shards[_s];
+		if (_start[_s] == _start[_s + 1]) {
+			continue;
+		}
+		pthread_mutex_lock(&_shard->_lock);
+		for (_i = _start[_s]; _i < _start[_s + 1]; _i++) {
+			avlt_delete(&_shard->_avlt, _keys[_order[_i]]);
+		}
+		pthread_mutex_unlock(&_shard->_lock);
+	}
+	free(_order);
+}
+
+// Min-heap of shard cursors ordered by key.
+static void _heap_sift_down(avlt_itr_t *_heap, size_t _n, size_t _i)
+{
+	for (;;) {
+		size_t _min = _i;
+		size_t _l = 2 * _i + 1;
+		size_t _r = 2 * _i + 2;
+		avlt_itr_t _tmp;
+		if (_l < _n && _heap[_l]->_key < _heap[_min]->_key) {
+			_min = _l;
+		}
+		if (_r < _n && _heap[_r]->_key < _heap[_min]->_key) {
+			_min = _r;
+		}
+		if (_min == _i) {
+			return;
+		}
+		_tmp = _heap[_i];
+		_heap[_i] = _heap[_min];
+		_heap[_min] = _tmp;
+		_i = _min;
+	}
+}
+
+// Calls _callback on every entry with _lo <= key <= _hi in key order
+// across all shards, merging the per-shard cursors through a heap.  All
+// shard locks are held for the whole scan, taken in shard order.
+size_t avlt_shard_range(avlt_shard_t *_avlt_shard, uint _lo, uint _hi,
+			avlt_range_cb_t _callback, void *_arg)
+{
+	size_t _num_shards = _avlt_shard->_num_shards;
+	avlt_itr_t *_heap = (avlt_itr_t *) malloc(_num_shards *
+						  sizeof(avlt_itr_t));
+	size_t _heap_size = 0;
+	size_t _cnt = 0;
+	size_t _i;
+
+	assert(_heap != NULL);
+	for (_i = 0; _i < _num_shards; _i++) {
+		avlt_itr_t _itr;
+		pthread_mutex_lock(&_avlt_shard->_shards[_i]._lock);
+		_itr = avlt_lower_bound(&_avlt_shard->_shards[_i]._avlt, _lo);
+		if (_itr != NULL && _itr->_key <= _hi) {
+			_heap[_heap_size++] = _itr;
+		}
+	}
+	for (_i = _heap_size; _i-- > 0;) {
+		_heap_sift_down(_heap, _heap_size, _i);
+	}
+
+	while (_heap_size > 0) {
+		avlt_itr_t _itr = _heap[0];
+		_cnt++;
+		if (_callback(_itr->_key, _itr->_value, _arg) != 0) {
+			break;
+		}
+		_itr = avlt_iter_next(_itr);
+		if (_itr != NULL && _itr->_key <= _hi) {
+			_heap[0] = _itr;
+		} else {
+			_heap[0] = _heap[--_heap_size];
+		}
+		_heap_sift_down(_heap, _heap_size, 0);
+	}
+
+	for (_i = _num_shards; _i-- > 0;) {
+		pthread_mutex_unlock(&_avlt_shard->_shards[_i]._lock);
+	}
+	free(_heap);
+	return _cnt;
+}
@@ -0,0 +1,48 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_avlt_shard.h
+
+Sharded AVLTree map.  Keys are hashed over independently
+locked avlt_t shards so that writers on different shards
+do not contend.
+
+\**************************************************/
+
+#ifndef __C_AVLT_SHARD_H__
+#define __C_AVLT_SHARD_H__
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "c_avlt.h"
+
+#define AVLT_SHARD_CACHE_LINE (64)
+
+typedef struct _avlt_shard {
+	pthread_mutex_t _lock;
+	avlt_t _avlt;
+} __attribute__((aligned(AVLT_SHARD_CACHE_LINE))) _avlt_shard_t;
+
+typedef struct c_avlt_shard {
+	_avlt_shard_t *_shards;
+	size_t _num_shards;
+} avlt_shard_t;
+
+void avlt_shard_init(avlt_shard_t *_avlt_shard, size_t _num_shards);
+void avlt_shard_destroy(avlt_shard_t *_avlt_shard);
+void *avlt_shard_search(avlt_shard_t *_avlt_shard, uint _key);
+void avlt_shard_insert(avlt_shard_t *_avlt_shard, uint _key, void *_value);
+void avlt_shard_delete(avlt_shard_t *_avlt_shard, uint _key);
+size_t avlt_shard_size(avlt_shard_t *_avlt_shard);
+void avlt_shard_search_batch(avlt_shard_t *_avlt_shard, const uint *_keys,
+			     void **_out, size_t _n);
+void avlt_shard_insert_batch(avlt_shard_t *_avlt_shard, const uint *_keys,
+			     void **_values, size_t _n);
+void avlt_shard_delete_batch(avlt_shard_t *_avlt_shard, const uint *_keys,
+			     size_t _n);
+size_t avlt_shard_range(avlt_shard_t *_avlt_shard, uint _lo, uint _hi,
+			avlt_range_cb_t _callback, void *_arg);
+
+#endif  // end of #ifndef __C_AVLT_SHARD_H__
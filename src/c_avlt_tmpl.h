@@ -0,0 +1,595 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_avlt_tmpl.h
+
+Template-style AVLTree.  Each inclusion generates a tree
+specialized for one key type and ordering, with the
+comparison inlined into the search loop.  Define the
+parameters below and include this file:
+
+	#define AVLT_TMPL_NAME avlt_u64
+	#define AVLT_TMPL_KEY_T uint64_t
+	#define AVLT_TMPL_LESS(_a, _b) ((_a) < (_b))	// optional
+	#include "c_avlt_tmpl.h"
+
+which yields avlt_u64_t, avlt_u64_itr_t, avlt_u64_init(),
+avlt_u64_search(), avlt_u64_insert(), avlt_u64_delete(),
+avlt_u64_clear(), avlt_u64_lower_bound() and
+avlt_u64_iter_next().  AVLT_TMPL_LESS defaults to the <
+operator.  Keys are passed by value and no key value is
+reserved as a sentinel.  Internal names (the node type and
+helpers) get an underscore in front of AVLT_TMPL_NAME, or
+AVLT_TMPL_PRIV_NAME if defined, which a NAME that already
+starts with an underscore needs.  The parameters are
+#undef'd at the end so the file can be included again for
+another tree.
+
+A node can also carry a summary of its subtree, kept up to
+date through inserts, deletes and rotations:
+
+	#define AVLT_TMPL_AUG_T uint64_t
+	#define AVLT_TMPL_AUG_LEAF(_key) ((_key)._end)
+	#define AVLT_TMPL_AUG_COMBINE(_a, _b) ((_a) > (_b) ? (_a) : (_b))
+
+sets _aug of every node to LEAF(_key) combined with the
+_aug of each child.  COMBINE must be associative and
+commutative.  See c_avlt_itv.h.
+
+There is deliberately no include guard.
+
+\**************************************************/
+
+#ifndef AVLT_TMPL_NAME
+#error "AVLT_TMPL_NAME must be defined before including c_avlt_tmpl.h"
+#endif
+#ifndef AVLT_TMPL_KEY_T
+#error "AVLT_TMPL_KEY_T must be defined before including c_avlt_tmpl.h"
+#endif
+#ifndef AVLT_TMPL_LESS
+#define AVLT_TMPL_LESS(_a, _b) ((_a) < (_b))
+#endif
+#if defined(AVLT_TMPL_AUG_T) && \
+	(!defined(AVLT_TMPL_AUG_LEAF) || !defined(AVLT_TMPL_AUG_COMBINE))
+#error "AVLT_TMPL_AUG_T needs AVLT_TMPL_AUG_LEAF and AVLT_TMPL_AUG_COMBINE"
+#endif
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "c_avlt.h"	// _LEFT, _RIGHT, ... and rotation types
+
+#define _AVLT_TMPL_CAT2(_a, _b) _a ## _b
+#define _AVLT_TMPL_CAT(_a, _b) _AVLT_TMPL_CAT2(_a, _b)
+#define _AVLT_TMPL_FN(_fn) _AVLT_TMPL_CAT(AVLT_TMPL_NAME, _fn)
+#ifdef AVLT_TMPL_PRIV_NAME
+#define _AVLT_TMPL_PRIV(_fn) _AVLT_TMPL_CAT(AVLT_TMPL_PRIV_NAME, _fn)
+#else
+#define _AVLT_TMPL_PRIV(_fn) _AVLT_TMPL_CAT(_, _AVLT_TMPL_FN(_fn))
+#endif
+
+#define _TREE_T _AVLT_TMPL_FN(_t)
+#define _NODE_T _AVLT_TMPL_PRIV(_node_t)
+#define _ITR_T _AVLT_TMPL_FN(_itr_t)
+
+typedef struct _AVLT_TMPL_PRIV(_node) {
+	AVLT_TMPL_KEY_T _key;
+	void *_value;
+	char _balance;
+	struct _AVLT_TMPL_PRIV(_node) *_parent;
+	struct _AVLT_TMPL_PRIV(_node) *_left_child;
+	struct _AVLT_TMPL_PRIV(_node) *_right_child;
+#ifdef AVLT_TMPL_AUG_T
+	AVLT_TMPL_AUG_T _aug;	// summary of this subtree
+#endif
+} _NODE_T;
+
+typedef struct _AVLT_TMPL_FN(_s) {
+	_NODE_T *_root;
+	size_t _size;
+} _TREE_T;
+
+typedef _NODE_T * _ITR_T;
+
+static inline int _AVLT_TMPL_PRIV(_compare)(AVLT_TMPL_KEY_T _node_key,
+					    AVLT_TMPL_KEY_T _input_key)
+{
+	if (AVLT_TMPL_LESS(_input_key, _node_key)) {
+		return _LEFT;
+	} else if (AVLT_TMPL_LESS(_node_key, _input_key)) {
+		return _RIGHT;
+	} else {
+		return _EQUAL;
+	}
+}
+
+// Recomputes _node->_aug from its key and its children.
+static inline void _AVLT_TMPL_PRIV(_aug_update)(_NODE_T *_node)
+{
+#ifdef AVLT_TMPL_AUG_T
+	_node->_aug = AVLT_TMPL_AUG_LEAF(_node->_key);
+	if (_node->_left_child != NULL) {
+		_node->_aug = AVLT_TMPL_AUG_COMBINE(_node->_aug,
+						    _node->_left_child->_aug);
+	}
+	if (_node->_right_child != NULL) {
+		_node->_aug = AVLT_TMPL_AUG_COMBINE(_node->_aug,
+						    _node->_right_child->_aug);
+	}
+#else
+	(void) _node;
+#endif
+}
+
+// Called after a subtree changed below _node and before rebalancing, so
+// that rotations only ever combine up-to-date children.  Rotations do
+// not change what lies under the nodes above them.
+static inline void _AVLT_TMPL_PRIV(_aug_update_to_root)(_NODE_T *_node)
+{
+#ifdef AVLT_TMPL_AUG_T
+	while (_node != NULL) {
+		_AVLT_TMPL_PRIV(_aug_update)(_node);
+		_node = _node->_parent;
+	}
+#else
+	(void) _node;
+#endif
+}
+
+// Hooks _new_top into the place _old_top had under _parent.
+static inline void _AVLT_TMPL_PRIV(_replace_child)(_TREE_T *_avlt,
+						   _NODE_T *_parent,
+						   _NODE_T *_old_top,
+						   _NODE_T *_new_top)
+{
+	if (_parent != NULL) {
+		if (_parent->_right_child == _old_top) {
+			_parent->_right_child = _new_top;
+		} else {
+			assert(_parent->_left_child == _old_top);
+			_parent->_left_child = _new_top;
+		}
+	} else {
+		_avlt->_root = _new_top;
+	}
+	_new_top->_parent = _parent;
+}
+
+static inline void _AVLT_TMPL_PRIV(_rr_rotation)(_TREE_T *_avlt,
+						 _NODE_T *_top,
+						 _NODE_T *_middle)
+{
+	_NODE_T *_parent = _top->_parent;
+	_top->_left_child = _middle->_right_child;
+	if (_top->_left_child != NULL) {
+		_top->_left_child->_parent = _top;
+	}
+	_top->_parent = _middle;
+	_middle->_right_child = _top;
+	_AVLT_TMPL_PRIV(_replace_child)(_avlt, _parent, _top, _middle);
+	_AVLT_TMPL_PRIV(_aug_update)(_top);
+	_AVLT_TMPL_PRIV(_aug_update)(_middle);
+}
+
+static inline void _AVLT_TMPL_PRIV(_ll_rotation)(_TREE_T *_avlt,
+						 _NODE_T *_top,
+						 _NODE_T *_middle)
+{
+	_NODE_T *_parent = _top->_parent;
+	_top->_right_child = _middle->_left_child;
+	if (_top->_right_child != NULL) {
+		_top->_right_child->_parent = _top;
+	}
+	_top->_parent = _middle;
+	_middle->_left_child = _top;
+	_AVLT_TMPL_PRIV(_replace_child)(_avlt, _parent, _top, _middle);
+	_AVLT_TMPL_PRIV(_aug_update)(_top);
+	_AVLT_TMPL_PRIV(_aug_update)(_middle);
+}
+
+static inline void _AVLT_TMPL_PRIV(_lr_rotation)(_TREE_T *_avlt,
+						 _NODE_T *_top,
+						 _NODE_T *_middle,
+						 _NODE_T *_bottom)
+{
+	_NODE_T *_parent = _top->_parent;
+	_top->_left_child = _bottom->_right_child;
+	if (_top->_left_child != NULL) {
+		_top->_left_child->_parent = _top;
+	}
+	_top->_parent = _bottom;
+	_bottom->_right_child = _top;
+	_middle->_right_child = _bottom->_left_child;
+	if (_middle->_right_child != NULL) {
+		_middle->_right_child->_parent = _middle;
+	}
+	_middle->_parent = _bottom;
+	_bottom->_left_child = _middle;
+	_AVLT_TMPL_PRIV(_replace_child)(_avlt, _parent, _top, _bottom);
+	_AVLT_TMPL_PRIV(_aug_update)(_top);
+	_AVLT_TMPL_PRIV(_aug_update)(_middle);
+	_AVLT_TMPL_PRIV(_aug_update)(_bottom);
+}
+
+static inline void _AVLT_TMPL_PRIV(_rl_rotation)(_TREE_T *_avlt,
+						 _NODE_T *_top,
+						 _NODE_T *_middle,
+						 _NODE_T *_bottom)
+{
+	_NODE_T *_parent = _top->_parent;
+	_top->_right_child = _bottom->_left_child;
+	if (_top->_right_child != NULL) {
+		_top->_right_child->_parent = _top;
+	}
+	_top->_parent = _bottom;
+	_bottom->_left_child = _top;
+	_middle->_left_child = _bottom->_right_child;
+	if (_middle->_left_child != NULL) {
+		_middle->_left_child->_parent = _middle;
+	}
+	_middle->_parent = _bottom;
+	_bottom->_right_child = _middle;
+	_AVLT_TMPL_PRIV(_replace_child)(_avlt, _parent, _top, _bottom);
+	_AVLT_TMPL_PRIV(_aug_update)(_top);
+	_AVLT_TMPL_PRIV(_aug_update)(_middle);
+	_AVLT_TMPL_PRIV(_aug_update)(_bottom);
+}
+
+// Balances after a double rotation; the same after insert and delete.
+static inline void _AVLT_TMPL_PRIV(_balance_adjust_double)(int _rotation_type,
+							   _NODE_T *_top,
+							   _NODE_T *_middle,
+							   _NODE_T *_bottom)
+{
+	if (_bottom->_balance == _EQUAL) {
+		_middle->_balance = 0;
+		_top->_balance = 0;
+	} else if ((_bottom->_balance == _LEFT) == (_rotation_type == _RL)) {
+		_middle->_balance = (_rotation_type == _RL) ? _RIGHT : _LEFT;
+		_top->_balance = 0;
+	} else {
+		_middle->_balance = 0;
+		_top->_balance = (_rotation_type == _RL) ? _LEFT : _RIGHT;
+	}
+	_bottom->_balance = 0;
+}
+
+static inline void _AVLT_TMPL_PRIV(_balance_after_insert)(_TREE_T *_avlt,
+							  _NODE_T *_node,
+							  _NODE_T *_new_node)
+{
+	_NODE_T *prevprev = _new_node;
+	_NODE_T *prev = _node;
+	_NODE_T *curr = _node->_parent;
+
+	if (_node->_balance == 0) {
+		return;
+	}
+
+	while (curr != NULL) {
+		if (curr->_left_child == prev) {
+			curr->_balance = curr->_balance + _LEFT;
+		} else {
+			curr->_balance = curr->_balance + _RIGHT;
+		}
+
+		// This means there is no more hight change propagation
+		if (curr->_balance == 0) {
+			break;
+		}
+
+		if (curr->_balance == _LEFT2X) {
+			if (prev->_balance == _LEFT) {
+				_AVLT_TMPL_PRIV(_rr_rotation)(_avlt, curr, prev);
+				curr->_balance = 0;
+				prev->_balance = 0;
+			} else {
+				_AVLT_TMPL_PRIV(_lr_rotation)(_avlt, curr, prev,
+							      prevprev);
+				_AVLT_TMPL_PRIV(_balance_adjust_double)(
+					_LR, curr, prev, prevprev);
+			}
+			break;
+		} else if (curr->_balance == _RIGHT2X) {
+			if (prev->_balance == _RIGHT) {
+				_AVLT_TMPL_PRIV(_ll_rotation)(_avlt, curr, prev);
+				curr->_balance = 0;
+				prev->_balance = 0;
+			} else {
+				_AVLT_TMPL_PRIV(_rl_rotation)(_avlt, curr, prev,
+							      prevprev);
+				_AVLT_TMPL_PRIV(_balance_adjust_double)(
+					_RL, curr, prev, prevprev);
+			}
+			break;
+		}
+		prevprev = prev;
+		prev = curr;
+		curr = curr->_parent;
+	}  // end of while (curr != NULL)
+}
+
+static inline void _AVLT_TMPL_PRIV(_balance_after_delete)(_TREE_T *_avlt,
+							  _NODE_T *_node)
+{
+	_NODE_T *_top = _node;
+	_NODE_T *_middle;
+	_NODE_T *_bottom;
+
+	if (_node->_balance == _LEFT || _node->_balance == _RIGHT) {
+		return;
+	}
+
+	while (_top != NULL) {
+		if (_top->_balance == _LEFT2X) {
+			_middle = _top->_left_child;
+			if (_middle->_balance == _RIGHT) {
+				_bottom = _middle->_right_child;
+				_AVLT_TMPL_PRIV(_lr_rotation)(_avlt, _top,
+							      _middle, _bottom);
+				_AVLT_TMPL_PRIV(_balance_adjust_double)(
+					_LR, _top, _middle, _bottom);
+			} else {
+				_AVLT_TMPL_PRIV(_rr_rotation)(_avlt, _top,
+							      _middle);
+				if (_middle->_balance == _LEFT) {
+					_top->_balance = 0;
+					_middle->_balance = 0;
+				} else {
+					_top->_balance = _LEFT;
+					_middle->_balance = _RIGHT;
+				}
+			}
+		} else if (_top->_balance == _RIGHT2X) {
+			_middle = _top->_right_child;
+			if (_middle->_balance == _LEFT) {
+				_bottom = _middle->_left_child;
+				_AVLT_TMPL_PRIV(_rl_rotation)(_avlt, _top,
+							      _middle, _bottom);
+				_AVLT_TMPL_PRIV(_balance_adjust_double)(
+					_RL, _top, _middle, _bottom);
+			} else {
+				_AVLT_TMPL_PRIV(_ll_rotation)(_avlt, _top,
+							      _middle);
+				if (_middle->_balance == _RIGHT) {
+					_top->_balance = 0;
+					_middle->_balance = 0;
+				} else {
+					_top->_balance = _RIGHT;
+					_middle->_balance = _LEFT;
+				}
+			}
+		} else if (_top->_balance == 0) {
+			if (_top->_parent != NULL) {
+				if (_top == _top->_parent->_left_child) {
+					_top->_parent->_balance -= _LEFT;
+				} else {
+					_top->_parent->_balance -= _RIGHT;
+				}
+			}
+		} else {
+			break;
+		}
+		_top = _top->_parent;
+	}
+}
+
+// returns NULL if key is not found
+static inline _NODE_T * _AVLT_TMPL_PRIV(_map_search)(_TREE_T *_avlt,
+						     AVLT_TMPL_KEY_T _key)
+{
+	_NODE_T *_curr = _avlt->_root;
+	while (_curr != NULL) {
+		int _cmp_result = _AVLT_TMPL_PRIV(_compare)(_curr->_key, _key);
+		if (_cmp_result == _LEFT) {
+			_curr = _curr->_left_child;
+		} else if (_cmp_result == _RIGHT) {
+			_curr = _curr->_right_child;
+		} else {
+			return _curr;
+		}
+	}
+	return _curr;
+}
+
+static inline void _AVLT_TMPL_FN(_init)(_TREE_T *_avlt)
+{
+	_avlt->_root = NULL;
+	_avlt->_size = 0;
+}
+
+static inline void * _AVLT_TMPL_FN(_search)(_TREE_T *_avlt,
+					    AVLT_TMPL_KEY_T _key)
+{
+	_NODE_T *_found = _AVLT_TMPL_PRIV(_map_search)(_avlt, _key);
+	return (_found != NULL) ? _found->_value : NULL;
+}
+
+static inline void _AVLT_TMPL_FN(_insert)(_TREE_T *_avlt,
+					  AVLT_TMPL_KEY_T _key, void *_value)
+{
+	int _cmp_result = _EQUAL;
+	_NODE_T *_curr = _avlt->_root;
+	_NODE_T *_new_node = (_NODE_T *) malloc(sizeof(_NODE_T));
+
+	assert(_new_node != NULL);
+	_new_node->_key = _key;
+	_new_node->_value = _value;
+	_new_node->_balance = 0;
+	_new_node->_parent = NULL;
+	_new_node->_left_child = NULL;
+	_new_node->_right_child = NULL;
+	_AVLT_TMPL_PRIV(_aug_update)(_new_node);
+	_avlt->_size++;
+
+	if (_curr == NULL) {
+		_avlt->_root = _new_node;
+		return;
+	}
+
+	// Find insertion point, the _parent of new node.
+	for (;;) {
+		_cmp_result = _AVLT_TMPL_PRIV(_compare)(_curr->_key, _key);
+		if (_cmp_result == _LEFT && _curr->_left_child != NULL) {
+			_curr = _curr->_left_child;
+		} else if (_cmp_result == _RIGHT &&
+			   _curr->_right_child != NULL) {
+			_curr = _curr->_right_child;
+		} else {
+			break;
+		}
+	}
+	if (_cmp_result == _EQUAL) {
+		fprintf(stderr, "ERROR: Redundant key found while "
+			"inserting!\n");
+		assert(false);
+	}
+
+	_new_node->_parent = _curr;
+	if (_cmp_result == _LEFT) {
+		_curr->_left_child = _new_node;
+		_curr->_balance = _curr->_balance + _LEFT;
+	} else {
+		_curr->_right_child = _new_node;
+		_curr->_balance = _curr->_balance + _RIGHT;
+	}
+	_AVLT_TMPL_PRIV(_aug_update_to_root)(_curr);
+	_AVLT_TMPL_PRIV(_balance_after_insert)(_avlt, _curr, _new_node);
+}
+
+static inline void _AVLT_TMPL_FN(_delete)(_TREE_T *_avlt,
+					  AVLT_TMPL_KEY_T _key)
+{
+	_NODE_T *_node_to_delete = _AVLT_TMPL_PRIV(_map_search)(_avlt, _key);
+	_NODE_T *_replacement_node;
+	_NODE_T *_node_to_attach;
+	_NODE_T *_parent;
+
+	assert(_node_to_delete != NULL);
+
+	_avlt->_size--;
+	if (_avlt->_size == 0) {
+		_avlt->_root = NULL;
+		free(_node_to_delete);
+		return;
+	}
+
+	// Find max of left subtree or min of right subtree
+	_replacement_node = _node_to_delete->_left_child;
+	if (_replacement_node != NULL) {
+		while (_replacement_node->_right_child != NULL) {
+			_replacement_node = _replacement_node->_right_child;
+		}
+	} else {
+		_replacement_node = _node_to_delete->_right_child;
+		while (_replacement_node != NULL &&
+		       _replacement_node->_left_child != NULL) {
+			_replacement_node = _replacement_node->_left_child;
+		}
+	}
+
+	if (_replacement_node != NULL) {
+		// Move the replacement entry up and delete its node.
+		_node_to_delete->_key = _replacement_node->_key;
+		_node_to_delete->_value = _replacement_node->_value;
+		_node_to_delete = _replacement_node;
+	}
+
+	// _node_to_delete has a _parent and at most one child now.
+	_parent = _node_to_delete->_parent;
+	_node_to_attach = (_node_to_delete->_left_child != NULL) ?
+		_node_to_delete->_left_child : _node_to_delete->_right_child;
+
+	if (_parent->_left_child == _node_to_delete) {
+		_parent->_left_child = _node_to_attach;
+		_parent->_balance = _parent->_balance - _LEFT;
+	} else {
+		_parent->_right_child = _node_to_attach;
+		_parent->_balance = _parent->_balance - _RIGHT;
+	}
+	if (_node_to_attach != NULL) {
+		_node_to_attach->_parent = _parent;
+	}
+
+	free(_node_to_delete);
+
+	_AVLT_TMPL_PRIV(_aug_update_to_root)(_parent);
+	_AVLT_TMPL_PRIV(_balance_after_delete)(_avlt, _parent);
+}
+
+// Frees every node in one iterative post-order walk.
+static inline void _AVLT_TMPL_FN(_clear)(_TREE_T *_avlt)
+{
+	_NODE_T *_node = _avlt->_root;
+	while (_node != NULL) {
+		if (_node->_left_child != NULL) {
+			_node = _node->_left_child;
+		} else if (_node->_right_child != NULL) {
+			_node = _node->_right_child;
+		} else {
+			_NODE_T *_parent = _node->_parent;
+			if (_parent != NULL) {
+				if (_parent->_left_child == _node) {
+					_parent->_left_child = NULL;
+				} else {
+					_parent->_right_child = NULL;
+				}
+			}
+			free(_node);
+			_node = _parent;
+		}
+	}
+	_AVLT_TMPL_FN(_init)(_avlt);
+}
+
+// Returns the first entry whose key is not ordered before _key, or NULL.
+static inline _ITR_T _AVLT_TMPL_FN(_lower_bound)(_TREE_T *_avlt,
+						 AVLT_TMPL_KEY_T _key)
+{
+	_NODE_T *_curr = _avlt->_root;
+	_NODE_T *_bound = NULL;
+	while (_curr != NULL) {
+		if (AVLT_TMPL_LESS(_curr->_key, _key)) {
+			_curr = _curr->_right_child;
+		} else {
+			_bound = _curr;
+			_curr = _curr->_left_child;
+		}
+	}
+	return _bound;
+}
+
+static inline _ITR_T _AVLT_TMPL_FN(_iter_next)(_ITR_T _itr)
+{
+	_NODE_T *_node = _itr;
+	if (_node->_right_child != NULL) {
+		_node = _node->_right_child;
+		while (_node->_left_child != NULL) {
+			_node = _node->_left_child;
+		}
+		return _node;
+	}
+	while (_node->_parent != NULL && _node->_parent->_right_child == _node) {
+		_node = _node->_parent;
+	}
+	return _node->_parent;
+}
+
+#undef _TREE_T
+#undef _NODE_T
+#undef _ITR_T
+#undef _AVLT_TMPL_PRIV
+#undef _AVLT_TMPL_FN
+#undef _AVLT_TMPL_CAT
+#undef _AVLT_TMPL_CAT2
+
+#undef AVLT_TMPL_NAME
+#undef AVLT_TMPL_PRIV_NAME
+#undef AVLT_TMPL_KEY_T
+#undef AVLT_TMPL_LESS
+#undef AVLT_TMPL_AUG_T
+#undef AVLT_TMPL_AUG_LEAF
+#undef AVLT_TMPL_AUG_COMBINE
@@ -0,0 +1,55 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_avlt_types.h
+
+Ready-made specializations of c_avlt_tmpl.h.
+
+avlt_u64_t	64-bit unsigned integer keys.
+avlt_b16_t	16-byte keys in memcmp() order, compared as two
+		big-endian 64-bit words.
+
+\**************************************************/
+
+#ifndef __C_AVLT_TYPES_H__
+#define __C_AVLT_TYPES_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define AVLT_TMPL_NAME avlt_u64
+#define AVLT_TMPL_KEY_T uint64_t
+#include "c_avlt_tmpl.h"
+
+typedef struct avlt_b16_key {
+	unsigned char _bytes[16];
+} avlt_b16_key_t;
+
+static inline uint64_t _avlt_b16_word(const unsigned char *_bytes)
+{
+	uint64_t _word;
+	memcpy(&_word, _bytes, sizeof(_word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	_word = __builtin_bswap64(_word);
+#endif
+	return _word;
+}
+
+static inline bool avlt_b16_key_less(avlt_b16_key_t _a, avlt_b16_key_t _b)
+{
+	uint64_t _a_hi = _avlt_b16_word(_a._bytes);
+	uint64_t _b_hi = _avlt_b16_word(_b._bytes);
+	if (_a_hi != _b_hi) {
+		return _a_hi < _b_hi;
+	}
+	return _avlt_b16_word(_a._bytes + 8) < _avlt_b16_word(_b._bytes + 8);
+}
+
+#define AVLT_TMPL_NAME avlt_b16
+#define AVLT_TMPL_KEY_T avlt_b16_key_t
+#define AVLT_TMPL_LESS(_a, _b) avlt_b16_key_less(_a, _b)
+#include "c_avlt_tmpl.h"
+
+#endif  // end of #ifndef __C_AVLT_TYPES_H__
@@ -0,0 +1,577 @@
+/**************************************************
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_avltc.c
+
+Compact C-based AVLTree implementation.  Same algorithm as
+c_avlt.c with node pointers replaced by arena indices.
+
+**************************************************/
+
+#include "c_avltc.h"
+#include "c_avlt.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#define _NODE(_t, _i) ((_t)->_nodes[_i])
+
+static inline uint _get_parent(avltc_t *_avltc, uint _node)
+{
+	return _NODE(_avltc, _node)._parent_balance & _AVLTC_INDEX_MASK;
+}
+
+static inline void _set_parent(avltc_t *_avltc, uint _node, uint _parent)
+{
+	_NODE(_avltc, _node)._parent_balance =
+		(_NODE(_avltc, _node)._parent_balance & ~_AVLTC_INDEX_MASK) |
+		_parent;
+}
+
+static inline int _get_balance(avltc_t *_avltc, uint _node)
+{
+	return (int) (_NODE(_avltc, _node)._parent_balance >>
+		      _AVLTC_INDEX_BITS) - 2;
+}
+
+static inline void _set_balance(avltc_t *_avltc, uint _node, int _balance)
+{
+	assert(_balance >= _RIGHT2X && _balance <= _LEFT2X);
+	_NODE(_avltc, _node)._parent_balance =
+		(_NODE(_avltc, _node)._parent_balance & _AVLTC_INDEX_MASK) |
+		((uint) (_balance + 2) << _AVLTC_INDEX_BITS);
+}
+
+static uint _create_new_node(avltc_t *_avltc)
+{
+	uint _node = _avltc->_free_list;
+	if (_node != _AVLTC_NIL) {
+		_avltc->_free_list = _NODE(_avltc, _node)._left_child;
+	} else {
+		if (_avltc->_used == _avltc->_capacity) {
+			uint _capacity = _avltc->_capacity * 2;
+			if (_capacity > AVLTC_MAX_NODES) {
+				_capacity = AVLTC_MAX_NODES;
+			}
+			if (_capacity == _avltc->_capacity) {
+				fprintf(stderr, "ERROR: Compact AVL tree is "
+					"full!\n");
+				exit(EXIT_FAILURE);
+			}
+			_avltc->_nodes = (_avltc_node_t *)
+				realloc(_avltc->_nodes,
+					_capacity * sizeof(_avltc_node_t));
+			assert(_avltc->_nodes != NULL);
+			_avltc->_capacity = _capacity;
+		}
+		_node = _avltc->_used++;
+	}
+	_NODE(_avltc, _node)._key = _INIT_VAL;
+	_NODE(_avltc, _node)._value = NULL;
+	_NODE(_avltc, _node)._parent_balance = _AVLTC_NIL;
+	_set_balance(_avltc, _node, 0);
+	_NODE(_avltc, _node)._left_child = _AVLTC_NIL;
+	_NODE(_avltc, _node)._right_child = _AVLTC_NIL;
+	return _node;
+}
+
+static inline void _free_node(avltc_t *_avltc, uint _node)
+{
+	_NODE(_avltc, _node)._left_child = _avltc->_free_list;
+	_avltc->_free_list = _node;
+}
+
+static inline int compare(uint _node_key, uint _input_key)
+{
+	if (_node_key > _input_key) {
+		return _LEFT;
+	} else if (_node_key < _input_key) {
+		return _RIGHT;
+	} else {
+		return _EQUAL;
+	}
+}
+
+static inline uint _get_max_of_left_subtree(avltc_t *_avltc, uint _node)
+{
+	_node = _NODE(_avltc, _node)._left_child;
+	if (_node != _AVLTC_NIL) {
+		while (_NODE(_avltc, _node)._right_child != _AVLTC_NIL) {
+			_node = _NODE(_avltc, _node)._right_child;
+		}
+	}
+	return _node;
+}
+
+static inline uint _get_min_of_right_subtree(avltc_t *_avltc, uint _node)
+{
+	_node = _NODE(_avltc, _node)._right_child;
+	if (_node != _AVLTC_NIL) {
+		while (_NODE(_avltc, _node)._left_child != _AVLTC_NIL) {
+			_node = _NODE(_avltc, _node)._left_child;
+		}
+	}
+	return _node;
+}
+
+static inline void _balance_adjust_after_insertion_turn(avltc_t *_avltc,
+							int _rotation_type,
+							uint _top,
+							uint _middle,
+							uint _bottom)
+{
+	int _bottom_balance;
+	switch (_rotation_type) {
+	case _RR:
+	case _LL:
+		_set_balance(_avltc, _top, 0);
+		_set_balance(_avltc, _middle, 0);
+		break;
+	case _RL:
+	case _LR:
+		_bottom_balance = _get_balance(_avltc, _bottom);
+		if (_rotation_type == _LR) {
+			_bottom_balance = -_bottom_balance;
+		}
+		// Written for _RL; _LR is the mirror image.
+		if (_bottom_balance == _LEFT) {
+			_set_balance(_avltc, _middle,
+				     _rotation_type == _RL ? _RIGHT : _LEFT);
+			_set_balance(_avltc, _top, 0);
+		} else if (_bottom_balance == _RIGHT) {
+			_set_balance(_avltc, _middle, 0);
+			_set_balance(_avltc, _top,
+				     _rotation_type == _RL ? _LEFT : _RIGHT);
+		} else {
+			_set_balance(_avltc, _middle, 0);
+			_set_balance(_avltc, _top, 0);
+		}
+		_set_balance(_avltc, _bottom, 0);
+		break;
+	default:
+		fprintf(stderr, "ERROR: Unknown rotation type!\n");
+		exit(1);
+	}
+}
+
+static inline void _balance_adjust_after_deletion_turn(avltc_t *_avltc,
+						       int _rotation_type,
+						       uint _top,
+						       uint _middle,
+						       uint _bottom)
+{
+	switch (_rotation_type) {
+	case _RR:
+		if (_get_balance(_avltc, _middle) == _LEFT) {
+			_set_balance(_avltc, _top, 0);
+			_set_balance(_avltc, _middle, 0);
+		} else {
+			assert(_get_balance(_avltc, _middle) == 0);
+			_set_balance(_avltc, _top, _LEFT);
+			_set_balance(_avltc, _middle, _RIGHT);
+		}
+		break;
+	case _LL:
+		if (_get_balance(_avltc, _middle) == _RIGHT) {
+			_set_balance(_avltc, _top, 0);
+			_set_balance(_avltc, _middle, 0);
+		} else {
+			assert(_get_balance(_avltc, _middle) == 0);
+			_set_balance(_avltc, _top, _RIGHT);
+			_set_balance(_avltc, _middle, _LEFT);
+		}
+		break;
+	case _RL:
+	case _LR:
+		// Double rotations end up the same as after an insertion.
+		_balance_adjust_after_insertion_turn(_avltc, _rotation_type,
+						     _top, _middle, _bottom);
+		break;
+	default:
+		fprintf(stderr, "ERROR: Unknown rotation type!\n");
+		exit(1);
+	}
+}
+
+// Hooks _new_top into the place _old_top had under _parent.
+static inline void _replace_child(avltc_t *_avltc, uint _parent,
+				  uint _old_top, uint _new_top)
+{
+	if (_parent != _AVLTC_NIL) {
+		if (_NODE(_avltc, _parent)._right_child == _old_top) {
+			_NODE(_avltc, _parent)._right_child = _new_top;
+		} else if (_NODE(_avltc, _parent)._left_child == _old_top) {
+			_NODE(_avltc, _parent)._left_child = _new_top;
+		} else {
+			assert(false);
+		}
+	} else {
+		_avltc->_root = _new_top;
+	}
+	_set_parent(_avltc, _new_top, _parent);
+}
+
+static inline void _rr_rotation(avltc_t *_avltc, uint _top, uint _middle)
+{
+	uint _parent = _get_parent(_avltc, _top);
+	uint _child = _NODE(_avltc, _middle)._right_child;
+	_NODE(_avltc, _top)._left_child = _child;
+	if (_child != _AVLTC_NIL) {
+		_set_parent(_avltc, _child, _top);
+	}
+	_set_parent(_avltc, _top, _middle);
+	_NODE(_avltc, _middle)._right_child = _top;
+	_replace_child(_avltc, _parent, _top, _middle);
+}
+
+static inline void _ll_rotation(avltc_t *_avltc, uint _top, uint _middle)
+{
+	uint _parent = _get_parent(_avltc, _top);
+	uint _child = _NODE(_avltc, _middle)._left_child;
+	_NODE(_avltc, _top)._right_child = _child;
+	if (_child != _AVLTC_NIL) {
+		_set_parent(_avltc, _child, _top);
+	}
+	_set_parent(_avltc, _top, _middle);
+	_NODE(_avltc, _middle)._left_child = _top;
+	_replace_child(_avltc, _parent, _top, _middle);
+}
+
+static inline void _lr_rotation(avltc_t *_avltc, uint _top, uint _middle,
+				uint _bottom)
+{
+	uint _parent = _get_parent(_avltc, _top);
+	uint _child = _NODE(_avltc, _bottom)._right_child;
+	_NODE(_avltc, _top)._left_child = _child;
+	if (_child != _AVLTC_NIL) {
+		_set_parent(_avltc, _child, _top);
+	}
+	_set_parent(_avltc, _top, _bottom);
+	_NODE(_avltc, _bottom)._right_child = _top;
+	_child = _NODE(_avltc, _bottom)._left_child;
+	_NODE(_avltc, _middle)._right_child = _child;
+	if (_child != _AVLTC_NIL) {
+		_set_parent(_avltc, _child, _middle);
+	}
+	_set_parent(_avltc, _middle, _bottom);
+	_NODE(_avltc, _bottom)._left_child = _middle;
+	_replace_child(_avltc, _parent, _top, _bottom);
+}
+
+static inline void _rl_rotation(avltc_t *_avltc, uint _top, uint _middle,
+				uint _bottom)
+{
+	uint _parent = _get_parent(_avltc, _top);
+	uint _child = _NODE(_avltc, _bottom)._left_child;
+	_NODE(_avltc, _top)._right_child = _child;
+	if (_child != _AVLTC_NIL) {
+		_set_parent(_avltc, _child, _top);
+	}
+	_set_parent(_avltc, _top, _bottom);
+	_NODE(_avltc, _bottom)._left_child = _top;
+	_child = _NODE(_avltc, _bottom)._right_child;
+	_NODE(_avltc, _middle)._left_child = _child;
+	if (_child != _AVLTC_NIL) {
+		_set_parent(_avltc, _child, _middle);
+	}
+	_set_parent(_avltc, _middle, _bottom);
+	_NODE(_avltc, _bottom)._right_child = _middle;
+	_replace_child(_avltc, _parent, _top, _bottom);
+}
+
+static inline void _balance_after_insert(avltc_t *_avltc, uint _node,
+					 uint _new_node)
+{
+	assert(_get_balance(_avltc, _node) <= 1 &&
+	       _get_balance(_avltc, _node) >= -1);
+	if (_get_balance(_avltc, _node) == 0) {
+		return;
+	}
+	uint prevprev = _new_node;
+	uint prev = _node;
+	uint curr = _get_parent(_avltc, _node);
+
+	while (curr != _AVLTC_NIL) {
+		int _balance = _get_balance(_avltc, curr);
+		if (_NODE(_avltc, curr)._left_child == prev) {
+			_balance = _balance + _LEFT;
+		} else if (_NODE(_avltc, curr)._right_child == prev) {
+			_balance = _balance + _RIGHT;
+		} else {
+			assert(false);
+		}
+		_set_balance(_avltc, curr, _balance);
+
+		// This means there is no more hight change propagation
+		if (_balance == 0) {
+			break;
+		}
+
+		if (_balance == _LEFT2X) {
+			if (_get_balance(_avltc, prev) == _LEFT) {
+				_rr_rotation(_avltc, curr, prev);
+				_balance_adjust_after_insertion_turn(_avltc, _RR,
+								     curr, prev,
+								     _AVLTC_NIL);
+			} else {
+				_lr_rotation(_avltc, curr, prev, prevprev);
+				_balance_adjust_after_insertion_turn(_avltc, _LR,
+								     curr, prev,
+								     prevprev);
+			}
+			break;
+		} else if (_balance == _RIGHT2X) {
+			if (_get_balance(_avltc, prev) == _RIGHT) {
+				_ll_rotation(_avltc, curr, prev);
+				_balance_adjust_after_insertion_turn(_avltc, _LL,
+								     curr, prev,
+								     _AVLTC_NIL);
+			} else {
+				_rl_rotation(_avltc, curr, prev, prevprev);
+				_balance_adjust_after_insertion_turn(_avltc, _RL,
+								     curr, prev,
+								     prevprev);
+			}
+			break;
+		}
+		prevprev = prev;
+		prev = curr;
+		curr = _get_parent(_avltc, curr);
+	}  // end of while (curr != _AVLTC_NIL)
+}
+
+static inline void _balance_after_delete(avltc_t *_avltc, uint _node)
+{
+	if (_get_balance(_avltc, _node) == _LEFT ||
+	    _get_balance(_avltc, _node) == _RIGHT) {
+		return;
+	}
+
+	uint _top = _node;
+	uint _middle;
+	uint _bottom;
+
+	while (_top != _AVLTC_NIL) {
+		int _balance = _get_balance(_avltc, _top);
+		if (_balance == _LEFT2X) {
+			_middle = _NODE(_avltc, _top)._left_child;
+			if (_get_balance(_avltc, _middle) == _RIGHT) {
+				_bottom = _NODE(_avltc, _middle)._right_child;
+				_lr_rotation(_avltc, _top, _middle, _bottom);
+				_balance_adjust_after_deletion_turn(_avltc, _LR,
+								    _top,
+								    _middle,
+								    _bottom);
+			} else {
+				_rr_rotation(_avltc, _top, _middle);
+				_balance_adjust_after_deletion_turn(_avltc, _RR,
+								    _top,
+								    _middle,
+								    _AVLTC_NIL);
+			}
+		} else if (_balance == _RIGHT2X) {
+			_middle = _NODE(_avltc, _top)._right_child;
+			if (_get_balance(_avltc, _middle) == _LEFT) {
+				_bottom = _NODE(_avltc, _middle)._left_child;
+				_rl_rotation(_avltc, _top, _middle, _bottom);
+				_balance_adjust_after_deletion_turn(_avltc, _RL,
+								    _top,
+								    _middle,
+								    _bottom);
+			} else {
+				_ll_rotation(_avltc, _top, _middle);
+				_balance_adjust_after_deletion_turn(_avltc, _LL,
+								    _top,
+								    _middle,
+								    _AVLTC_NIL);
+			}
+		} else if (_balance == 0) {
+			uint _parent = _get_parent(_avltc, _top);
+			if (_parent != _AVLTC_NIL) {
+				int _parent_balance =
+					_get_balance(_avltc, _parent);
+				if (_top == _NODE(_avltc, _parent)._left_child) {
+					_parent_balance -= _LEFT;
+				} else if (_top ==
+					   _NODE(_avltc, _parent)._right_child) {
+					_parent_balance -= _RIGHT;
+				} else {
+					assert(false);
+				}
+				_set_balance(_avltc, _parent, _parent_balance);
+			}
+		} else {
+			break;
+		}
+		_top = _get_parent(_avltc, _top);
+	}
+}
+
+// returns _AVLTC_NIL if key is not found
+static inline uint _map_search(avltc_t *_avltc, uint _key)
+{
+	uint _curr = _avltc->_root;
+	while (_curr != _AVLTC_NIL) {
+		int _cmp_result = compare(_NODE(_avltc, _curr)._key, _key);
+		if (_cmp_result == _LEFT) {
+			_curr = _NODE(_avltc, _curr)._left_child;
+		} else if (_cmp_result == _RIGHT) {
+			_curr = _NODE(_avltc, _curr)._right_child;
+		} else {
+			return _curr;
+		}
+	}  // end of while (_curr != _AVLTC_NIL)
+	return _curr;
+}
+
+void avltc_init(avltc_t *_avltc)
+{
+	_avltc->_nodes = (_avltc_node_t *)
+		malloc(AVLTC_INIT_CAPACITY * sizeof(_avltc_node_t));
+	assert(_avltc->_nodes != NULL);
+	_avltc->_capacity = AVLTC_INIT_CAPACITY;
+	_avltc->_used = 1;	// slot 0 is _AVLTC_NIL
+	_avltc->_free_list = _AVLTC_NIL;
+	_avltc->_root = _AVLTC_NIL;
+	_avltc->_size = 0;
+}
+
+void avltc_destroy(avltc_t *_avltc)
+{
+	free(_avltc->_nodes);
+	_avltc->_nodes = NULL;
+	_avltc->_capacity = 0;
+	_avltc->_used = 0;
+	_avltc->_free_list = _AVLTC_NIL;
+	_avltc->_root = _AVLTC_NIL;
+	_avltc->_size = 0;
+}
+
+void * avltc_search(avltc_t *_avltc, uint _key)
+{
+	uint _found = _map_search(_avltc, _key);
+	if (_found == _AVLTC_NIL) {
+		return NULL;
+	} else {
+		return _NODE(_avltc, _found)._value;
+	}
+}
+
+void avltc_insert(avltc_t *_avltc, uint _key, void *_value)
+{
+	int _cmp_result = _EQUAL;
+	// Allocate first: growing the arena may move every node.
+	uint _new_node = _create_new_node(_avltc);
+	uint _curr = _avltc->_root;
+
+	_avltc->_size++;
+
+	_NODE(_avltc, _new_node)._key = _key;
+	_NODE(_avltc, _new_node)._value = _value;
+
+	if (_curr == _AVLTC_NIL) {
+		_avltc->_root = _new_node;
+		return;
+	}
+
+	// Find insertion point, the _parent of new node.
+	while (_curr != _AVLTC_NIL) {
+		_cmp_result = compare(_NODE(_avltc, _curr)._key, _key);
+		if (_cmp_result == _LEFT) {
+			if (_NODE(_avltc, _curr)._left_child != _AVLTC_NIL)
+				_curr = _NODE(_avltc, _curr)._left_child;
+			else
+				break;
+		} else if (_cmp_result == _RIGHT) {
+			if (_NODE(_avltc, _curr)._right_child != _AVLTC_NIL)
+				_curr = _NODE(_avltc, _curr)._right_child;
+			else
+				break;
+		} else {
+			fprintf(stderr, "ERROR: Redundant key (%u) value "
+				"found while inserting!\n", _key);
+			assert(false);
+		}
+	}  // end of while (_curr != _AVLTC_NIL)
+
+	_set_parent(_avltc, _new_node, _curr);
+	if (_cmp_result == _LEFT) {
+		_NODE(_avltc, _curr)._left_child = _new_node;
+		_set_balance(_avltc, _curr,
+			     _get_balance(_avltc, _curr) + _LEFT);
+	} else {
+		_NODE(_avltc, _curr)._right_child = _new_node;
+		_set_balance(_avltc, _curr,
+			     _get_balance(_avltc, _curr) + _RIGHT);
+	}
+	_balance_after_insert(_avltc, _curr, _new_node);
+}
+
+void avltc_delete(avltc_t *_avltc, uint _key)
+{
+	uint _node_to_delete = _map_search(_avltc, _key);
+
+	assert(_node_to_delete != _AVLTC_NIL);
+
+	uint _parent;
+	uint _node_to_attach = _AVLTC_NIL;
+
+	_avltc->_size--;
+	if (_avltc->_size == 0) {
+		_avltc->_root = _AVLTC_NIL;
+		_free_node(_avltc, _node_to_delete);
+		return;
+	}
+
+	// Find max of left sutree or min of right subtree
+	uint _replacement_node =
+		_get_max_of_left_subtree(_avltc, _node_to_delete);
+	if (_replacement_node == _AVLTC_NIL) {
+		_replacement_node =
+			_get_min_of_right_subtree(_avltc, _node_to_delete);
+	}
+
+	if (_replacement_node != _AVLTC_NIL) {
+		// Copy key and value of replacement node to the
+		// _node_to_delete and delete the replacement node instead.
+		_NODE(_avltc, _node_to_delete)._key =
+			_NODE(_avltc, _replacement_node)._key;
+		_NODE(_avltc, _node_to_delete)._value =
+			_NODE(_avltc, _replacement_node)._value;
+		_node_to_delete = _replacement_node;
+	}
+
+	_parent = _get_parent(_avltc, _node_to_delete);
+
+	// At this point, _node_to_delete is guranteed to have a
+	// _parent node and has at most one child node.
+	if (_NODE(_avltc, _node_to_delete)._left_child != _AVLTC_NIL) {
+		_node_to_attach = _NODE(_avltc, _node_to_delete)._left_child;
+	}
+	if (_NODE(_avltc, _node_to_delete)._right_child != _AVLTC_NIL) {
+		assert(_node_to_attach == _AVLTC_NIL);
+		_node_to_attach = _NODE(_avltc, _node_to_delete)._right_child;
+	}
+
+	// Attach the child from the _node_to_delete to the _parent,
+	// and adjust the balance.
+	if (_NODE(_avltc, _parent)._left_child == _node_to_delete) {
+		_NODE(_avltc, _parent)._left_child = _node_to_attach;
+		_set_balance(_avltc, _parent,
+			     _get_balance(_avltc, _parent) - _LEFT);
+	} else if (_NODE(_avltc, _parent)._right_child == _node_to_delete) {
+		_NODE(_avltc, _parent)._right_child = _node_to_attach;
+		_set_balance(_avltc, _parent,
+			     _get_balance(_avltc, _parent) - _RIGHT);
+	}
+	if (_node_to_attach != _AVLTC_NIL) {
+		_set_parent(_avltc, _node_to_attach, _parent);
+	}
+
+	_free_node(_avltc, _node_to_delete);
+
+	_balance_after_delete(_avltc, _parent);
+}
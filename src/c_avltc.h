@@ -0,0 +1,56 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_avltc.h
+
+Compact C-based AVLTree implementation.  Nodes live in one
+contiguous arena and link to each other by 32-bit indices,
+which brings an entry down to 24 bytes from the 48 bytes of
+_avlt_node_t.
+
+\**************************************************/
+
+#ifndef __C_AVLTC_H__
+#define __C_AVLTC_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+
+// Index 0 of the arena is never handed out and stands for NULL.
+#define _AVLTC_NIL (0)
+
+// The parent index and the balance share one word: the low
+// _AVLTC_INDEX_BITS bits hold the index, the upper bits hold
+// _balance + 2 (a balance transiently reaches _LEFT2X/_RIGHT2X
+// before rotating, so it needs three bits).
+#define _AVLTC_INDEX_BITS (29)
+#define _AVLTC_INDEX_MASK ((1U << _AVLTC_INDEX_BITS) - 1)
+#define AVLTC_MAX_NODES (_AVLTC_INDEX_MASK)
+
+#define AVLTC_INIT_CAPACITY (64)
+
+typedef struct _avltc_node {
+	uint _key;
+	uint _parent_balance;
+	uint _left_child;
+	uint _right_child;
+	void *_value;
+} _avltc_node_t;
+
+typedef struct c_avltc {
+	_avltc_node_t *_nodes;
+	uint _capacity;		// slots in _nodes, including _AVLTC_NIL
+	uint _used;		// slots ever handed out, including _AVLTC_NIL
+	uint _free_list;	// linked through _left_child
+	uint _root;
+	size_t _size;
+} avltc_t;
+
+void avltc_init(avltc_t *_avltc);
+void avltc_destroy(avltc_t *_avltc);
+void *avltc_search(avltc_t *_avltc, uint _key);
+void avltc_insert(avltc_t *_avltc, uint _key, void *_value);
+void avltc_delete(avltc_t *_avltc, uint _key);
+
+#endif  // end of #ifndef __C_AVLTC_H__
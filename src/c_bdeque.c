@@ -0,0 +1,288 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_bdeque.c
+
+C-based block deque implementation.
+
+\**************************************************/
+
+#include "c_bdeque.h"
+
+#include <assert.h>
+#include <string.h>
+
+#if (BDQ_BLOCK_SIZE & (BDQ_BLOCK_SIZE - 1)) != 0
+#error "BDQ_BLOCK_SIZE must be a power of two"
+#endif
+
+// Block pointer _i of the deque, counted from the first block in use.
+static inline void **_block(bdq_t *_bdq, size_t _i)
+{
+	return _bdq->_map[(_bdq->_map_head + _i) & (_bdq->_map_cap - 1)];
+}
+
+static inline void **_slot(bdq_t *_bdq, size_t _index)
+{
+	size_t _pos = _bdq->_head + _index;
+	return &_block(_bdq, _pos / BDQ_BLOCK_SIZE)[_pos % BDQ_BLOCK_SIZE];
+}
+
+static void **_get_block(bdq_t *_bdq)
+{
+	void **_block;
+	if (_bdq->_spares > 0) {
+		return _bdq->_spare[--_bdq->_spares];
+	}
+	_block = (void **) malloc(BDQ_BLOCK_SIZE * sizeof(void *));
+	assert(_block != NULL);
+	return _block;
+}
+
+static void _put_block(bdq_t *_bdq, void **_block)
+{
+	if (_bdq->_spares < BDQ_SPARE_BLOCKS) {
+		_bdq->_spare[_bdq->_spares++] = _block;
+	} else {
+		free(_block);
+	}
+}
+
+// Makes room for one more block pointer, doubling the ring and
+// unrolling it so that the first block lands in slot 0.
+static void _reserve_block(bdq_t *_bdq)
+{
+	size_t _cap;
+	size_t _i;
+	void ***_map;
+
+	if (_bdq->_blocks < _bdq->_map_cap) {
+		return;
+	}
+	_cap = (_bdq->_map_cap == 0) ? BDQ_MIN_MAP : _bdq->_map_cap * 2;
+	_map = (void ***) malloc(_cap * sizeof(void **));
+	assert(_map != NULL);
+	for (_i = 0; _i < _bdq->_blocks; _i++) {
+		_map[_i] = _block(_bdq, _i);
+	}
+	free(_bdq->_map);
+	_bdq->_map = _map;
+	_bdq->_map_cap = _cap;
+	_bdq->_map_head = 0;
+}
+
+void bdq_initialize(bdq_t *_bdq)
+{
+	memset(_bdq, 0, sizeof(bdq_t));
+}
+
+
+void bdq_push_front(bdq_t *_bdq, void *_data)
+{
+	if (_bdq->_head == 0) {
+		_reserve_block(_bdq);
+		_bdq->_map_head = (_bdq->_map_head - 1) & (_bdq->_map_cap - 1);
+		_bdq->_map[_bdq->_map_head] = _get_block(_bdq);
+		_bdq->_blocks++;
+		_bdq->_head = BDQ_BLOCK_SIZE;
+	}
+	_bdq->_head--;
+	_bdq->_size++;
+	_block(_bdq, 0)[_bdq->_head] = _data;
+}
+
+
+void bdq_push_back(bdq_t *_bdq, void *_data)
+{
+	size_t _end = _bdq->_head + _bdq->_size;
+	if (_end == _bdq->_blocks * BDQ_BLOCK_SIZE) {
+		_reserve_block(_bdq);
+		_bdq->_map[(_bdq->_map_head + _bdq->_blocks) &
+			   (_bdq->_map_cap - 1)] = _get_block(_bdq);
+		_bdq->_blocks++;
+	}
+	_block(_bdq, _end / BDQ_BLOCK_SIZE)[_end % BDQ_BLOCK_SIZE] = _data;
+	_bdq->_size++;
+}
+
+
+void *bdq_pop_front(bdq_t *_bdq)
+{
+	void *_return_data;
+	if (_bdq->_size == 0) {
+		fprintf(stderr, "ERROR: Attempt to remove from an "
+			"empty deque!\n");
+		exit(EXIT_FAILURE);
+	}
+	_return_data = _block(_bdq, 0)[_bdq->_head];
+	_bdq->_head++;
+	_bdq->_size--;
+	if (_bdq->_head == BDQ_BLOCK_SIZE) {
+		_put_block(_bdq, _block(_bdq, 0));
+		_bdq->_map_head = (_bdq->_map_head + 1) & (_bdq->_map_cap - 1);
+		_bdq->_blocks--;
+		_bdq->_head = 0;
+	}
+	return _return_data;
+}
+
+
+void *bdq_pop_back(bdq_t *_bdq)
+{
+	void *_return_data;
+	if (_bdq->_size == 0) {
+		fprintf(stderr, "ERROR: Attempt to remove from an "
+			"empty deque!\n");
+		exit(EXIT_FAILURE);
+	}
+	_bdq->_size--;
+	_return_data = *_slot(_bdq, _bdq->_size);
+	if (_bdq->_head + _bdq->_size <=
+	    (_bdq->_blocks - 1) * BDQ_BLOCK_SIZE) {
+		_put_block(_bdq, _block(_bdq, _bdq->_blocks - 1));
+		_bdq->_blocks--;
+		if (_bdq->_blocks == 0) {
+			_bdq->_head = 0;
+		}
+	}
+	return _return_data;
+}
+
+
+void bdq_print(bdq_t *_bdq, FILE *_fp)
+{
+	bdq_itr_t _itr;
+	for (_itr = bdq_get_itr(_bdq); !bdq_itr_end(_itr);
+	     _itr = bdq_itr_move_next(_itr)) {
+		fprintf(_fp, "%lld ", (long long int) bdq_itr_data(_itr));
+	}
+	fprintf(_fp, " (size=%zu) \n", bdq_size(_bdq));
+}
+
+
+void *bdq_front(bdq_t *_bdq)
+{
+	if (_bdq->_size == 0) {
+		fprintf(stderr, "ERROR: Attempt to get front from an "
+			"empty deque!\n");
+		exit(EXIT_FAILURE);
+	}
+	return _block(_bdq, 0)[_bdq->_head];
+}
+
+
+void *bdq_back(bdq_t *_bdq)
+{
+	if (_bdq->_size == 0) {
+		fprintf(stderr, "ERROR: Attempt to get back from an "
+			"empty deque!\n");
+		exit(EXIT_FAILURE);
+	}
+	return *_slot(_bdq, _bdq->_size - 1);
+}
+
+
+size_t bdq_size(bdq_t *_bdq)
+{
+	return _bdq->_size;
+}
+
+
+void *bdq_at(bdq_t *_bdq, size_t _index)
+{
+	if (_index >= _bdq->_size) {
+		fprintf(stderr, "ERROR: Attempt to access item at an "
+			"out of bound index!\n");
+		exit(EXIT_FAILURE);
+	}
+	return *_slot(_bdq, _index);
+}
+
+
+// Shifts the items on the shorter side of _index by one slot, so an
+// insert in the middle moves at most half the items.
+void bdq_insert_at(bdq_t *_bdq, size_t _index, void *_data)
+{
+	size_t _i;
+
+	assert(_index <= _bdq->_size);
+	if (_index < _bdq->_size / 2) {
+		bdq_push_front(_bdq, NULL);
+		for (_i = 0; _i < _index; _i++) {
+			*_slot(_bdq, _i) = *_slot(_bdq, _i + 1);
+		}
+	} else {
+		bdq_push_back(_bdq, NULL);
+		for (_i = _bdq->_size - 1; _i > _index; _i--) {
+			*_slot(_bdq, _i) = *_slot(_bdq, _i - 1);
+		}
+	}
+	*_slot(_bdq, _index) = _data;
+}
+
+
+void *bdq_erase_at(bdq_t *_bdq, size_t _index)
+{
+	void *_return_data;
+	size_t _i;
+
+	if (_index >= _bdq->_size) {
+		fprintf(stderr, "ERROR: Attempt to remove item at an "
+			"out of bound index!\n");
+		exit(EXIT_FAILURE);
+	}
+	_return_data = *_slot(_bdq, _index);
+	if (_index < _bdq->_size / 2) {
+		for (_i = _index; _i > 0; _i--) {
+			*_slot(_bdq, _i) = *_slot(_bdq, _i - 1);
+		}
+		bdq_pop_front(_bdq);
+	} else {
+		for (_i = _index + 1; _i < _bdq->_size; _i++) {
+			*_slot(_bdq, _i - 1) = *_slot(_bdq, _i);
+		}
+		bdq_pop_back(_bdq);
+	}
+	return _return_data;
+}
+
+
+// Frees every block, spare blocks and the map included.
+void bdq_clear(bdq_t *_bdq)
+{
+	size_t _i;
+	for (_i = 0; _i < _bdq->_blocks; _i++) {
+		free(_block(_bdq, _i));
+	}
+	for (_i = 0; _i < _bdq->_spares; _i++) {
+		free(_bdq->_spare[_i]);
+	}
+	free(_bdq->_map);
+	bdq_initialize(_bdq);
+}
+
+
+void *bdq_erase(bdq_t *_bdq, bdq_itr_t _bdq_itr)
+{
+	return bdq_erase_at(_bdq, _bdq_itr._index);
+}
+
+
+// Returns an iterator at _index, or the end past the last item.
+bdq_itr_t bdq_itr_at(bdq_t *_bdq, size_t _index)
+{
+	bdq_itr_t _itr = { _bdq, _index, NULL, 0 };
+	if (_index < _bdq->_size) {
+		_itr._slot = _slot(_bdq, _index);
+		_itr._run = BDQ_BLOCK_SIZE -
+			(_bdq->_head + _index) % BDQ_BLOCK_SIZE;
+	}
+	return _itr;
+}
+
+
+bdq_itr_t bdq_get_itr(bdq_t *_bdq)
+{
+	return bdq_itr_at(_bdq, 0);
+}
@@ -0,0 +1,96 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_bdeque.h
+
+C-based double ended queue built from fixed-size blocks of
+item slots, like std::deque.  A ring of block pointers maps
+an index to its block, so bdq_at is O(1), pushes and pops at
+either end only allocate when they cross into a new block,
+and iteration walks contiguous memory.
+
+Items move on bdq_insert_at and bdq_erase_at, so there are
+no stable handles like dq_itr_t; a bdq_itr_t is only valid
+until the deque changes.
+
+\**************************************************/
+
+#ifndef __C_BDEQUE_H__
+#define __C_BDEQUE_H__
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Item slots per block, a power of two.  512 slots make a 4KB block.
+#ifndef BDQ_BLOCK_SIZE
+#define BDQ_BLOCK_SIZE (512)
+#endif
+// Emptied blocks kept for reuse, so a deque that keeps crossing a block
+// boundary does not malloc and free on every crossing.
+#ifndef BDQ_SPARE_BLOCKS
+#define BDQ_SPARE_BLOCKS (4)
+#endif
+#define BDQ_MIN_MAP (8)
+
+typedef struct c_bdeque {
+	void ***_map;		// ring of _map_cap block pointers
+	size_t _map_cap;	// power of two
+	size_t _map_head;	// ring slot of the first block
+	size_t _blocks;		// blocks in use
+	size_t _head;		// slot of the first item in the first block
+	size_t _size;
+	void **_spare[BDQ_SPARE_BLOCKS];
+	size_t _spares;
+} bdq_t;
+
+typedef struct bdq_itr {
+	bdq_t *_bdq;
+	size_t _index;
+	void **_slot;		// NULL at the end
+	size_t _run;		// slots left in _slot's block, _slot included
+} bdq_itr_t;
+
+void bdq_initialize(bdq_t *_bdq);
+void bdq_push_front(bdq_t *_bdq, void *_data);
+void bdq_push_back(bdq_t *_bdq, void *_data);
+void *bdq_pop_front(bdq_t *_bdq);
+void *bdq_pop_back(bdq_t *_bdq);
+void *bdq_front(bdq_t *_bdq);
+void *bdq_back(bdq_t *_bdq);
+size_t bdq_size(bdq_t *_bdq);
+void *bdq_at(bdq_t *_bdq, size_t _index);
+void bdq_insert_at(bdq_t *_bdq, size_t _index, void *_data);
+void *bdq_erase_at(bdq_t *_bdq, size_t _index);
+void bdq_clear(bdq_t *_bdq);
+void bdq_print(bdq_t *_bdq, FILE *_fp);
+
+bdq_itr_t bdq_get_itr(bdq_t *_bdq);
+bdq_itr_t bdq_itr_at(bdq_t *_bdq, size_t _index);
+void *bdq_erase(bdq_t *_bdq, bdq_itr_t _bdq_itr);
+
+// Steps within a block by pointer and only goes through the map when
+// crossing into the next block.
+static inline bdq_itr_t bdq_itr_move_next(bdq_itr_t _bdq_itr)
+{
+	_bdq_itr._index++;
+	if (--_bdq_itr._run > 0 && _bdq_itr._index < _bdq_itr._bdq->_size) {
+		_bdq_itr._slot++;
+		return _bdq_itr;
+	}
+	return bdq_itr_at(_bdq_itr._bdq, _bdq_itr._index);
+}
+
+static inline bool bdq_itr_end(bdq_itr_t _bdq_itr)
+{
+	return _bdq_itr._slot == NULL;
+}
+
+static inline void *bdq_itr_data(bdq_itr_t _bdq_itr)
+{
+	return *_bdq_itr._slot;
+}
+
+#endif // end of __C_BDEQUE_H__
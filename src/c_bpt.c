@@ -0,0 +1,505 @@
+/**************************************************
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_bpt.c
+
+C-based B+-tree implementation.
+
+**************************************************/
+
+#include "c_bpt.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#if (BPT_NODE_KEYS % 4) != 0 || BPT_NODE_KEYS < 4
+#error "BPT_NODE_KEYS must be a positive multiple of 4"
+#endif
+
+#define _INNER(_node) ((_bpt_inner_t *) (_node))
+#define _LEAF(_node) ((_bpt_leaf_t *) (_node))
+
+#ifdef __SSE2__
+// SSE2 only compares signed integers, so both sides are moved by 2^31.
+#define _BIAS ((int) 0x80000000)
+
+// Number of the first _n keys of _node with _keys[i] < _key.  Whole
+// groups of 4 are compared; slots past _n are padded and never count.
+static inline uint _count_less(const _bpt_node_t *_node, uint _key)
+{
+	__m128i _bias = _mm_set1_epi32(_BIAS);
+	__m128i _k = _mm_xor_si128(_mm_set1_epi32((int) _key), _bias);
+	uint _cnt = 0;
+	uint _i;
+
+	for (_i = 0; _i < _node->_n; _i += 4) {
+		__m128i _v = _mm_load_si128((const __m128i *) &_node->_keys[_i]);
+		__m128i _lt = _mm_cmplt_epi32(_mm_xor_si128(_v, _bias), _k);
+		_cnt += __builtin_popcount(
+			_mm_movemask_ps(_mm_castsi128_ps(_lt)));
+	}
+	return _cnt;
+}
+
+// Number of the first _n keys of _node with _keys[i] <= _key.
+static inline uint _count_less_equal(const _bpt_node_t *_node, uint _key)
+{
+	__m128i _bias = _mm_set1_epi32(_BIAS);
+	__m128i _k = _mm_xor_si128(_mm_set1_epi32((int) _key), _bias);
+	uint _greater = 0;
+	uint _i;
+
+	for (_i = 0; _i < _node->_n; _i += 4) {
+		__m128i _v = _mm_load_si128((const __m128i *) &_node->_keys[_i]);
+		__m128i _gt = _mm_cmpgt_epi32(_mm_xor_si128(_v, _bias), _k);
+		_greater += __builtin_popcount(
+			_mm_movemask_ps(_mm_castsi128_ps(_gt)));
+	}
+	// Padding in the last group counts as greater unless _key is the
+	// pad value itself, hence the clamp.
+	_greater = _i - _greater;
+	return (_greater < _node->_n) ? _greater : _node->_n;
+}
+#else
+static inline uint _count_less(const _bpt_node_t *_node, uint _key)
+{
+	uint _lo = 0;
+	uint _hi = _node->_n;
+	while (_lo < _hi) {
+		uint _mid = (_lo + _hi) / 2;
+		if (_node->_keys[_mid] < _key) {
+			_lo = _mid + 1;
+		} else {
+			_hi = _mid;
+		}
+	}
+	return _lo;
+}
+
+static inline uint _count_less_equal(const _bpt_node_t *_node, uint _key)
+{
+	uint _lo = 0;
+	uint _hi = _node->_n;
+	while (_lo < _hi) {
+		uint _mid = (_lo + _hi) / 2;
+		if (_node->_keys[_mid] <= _key) {
+			_lo = _mid + 1;
+		} else {
+			_hi = _mid;
+		}
+	}
+	return _lo;
+}
+#endif
+
+static void *_alloc_node(bool _leaf)
+{
+	size_t _size = _leaf ? sizeof(_bpt_leaf_t) : sizeof(_bpt_inner_t);
+	_bpt_node_t *_node;
+	uint _i;
+
+	if (posix_memalign((void **) &_node, BPT_CACHE_LINE, _size) != 0) {
+		fprintf(stderr, "ERROR: B+-tree node allocation failed!\n");
+		exit(EXIT_FAILURE);
+	}
+	for (_i = 0; _i < BPT_NODE_KEYS; _i++) {
+		_node->_keys[_i] = _BPT_PAD;
+	}
+	_node->_n = 0;
+	_node->_leaf = _leaf;
+	if (_leaf) {
+		_LEAF(_node)->_next = NULL;
+	}
+	return _node;
+}
+
+// Refills the slots [_node->_n, _old_n) that a shrink left behind.
+static inline void _repad(_bpt_node_t *_node, uint _old_n)
+{
+	uint _i;
+	for (_i = _node->_n; _i < _old_n; _i++) {
+		_node->_keys[_i] = _BPT_PAD;
+	}
+}
+
+static inline _bpt_leaf_t *_find_leaf(bpt_t *_bpt, uint _key)
+{
+	_bpt_node_t *_node = _bpt->_root;
+	while (_node != NULL && !_node->_leaf) {
+		_node = _INNER(_node)->_children[_count_less_equal(_node, _key)];
+	}
+	return _LEAF(_node);
+}
+
+void bpt_init(bpt_t *_bpt)
+{
+	_bpt->_root = NULL;
+	_bpt->_size = 0;
+	_bpt->_height = 0;
+}
+
+static void _free_subtree(_bpt_node_t *_node)
+{
+	uint _i;
+	if (!_node->_leaf) {
+		for (_i = 0; _i <= _node->_n; _i++) {
+			_free_subtree(_INNER(_node)->_children[_i]);
+		}
+	}
+	free(_node);
+}
+
+void bpt_destroy(bpt_t *_bpt)
+{
+	if (_bpt->_root != NULL) {
+		_free_subtree(_bpt->_root);
+	}
+	bpt_init(_bpt);
+}
+
+void *bpt_search(bpt_t *_bpt, uint _key)
+{
+	_bpt_leaf_t *_leaf = _find_leaf(_bpt, _key);
+	uint _pos;
+
+	if (_leaf == NULL) {
+		return NULL;
+	}
+	_pos = _count_less(&_leaf->_node, _key);
+	if (_pos < _leaf->_node._n && _leaf->_node._keys[_pos] == _key) {
+		return _leaf->_values[_pos];
+	}
+	return NULL;
+}
+
+// Splits the full child at _idx of _parent, which has room for one
+// more key.  A leaf copies its first right key up, an inner node moves
+// its middle key up.
+static void _split_child(_bpt_inner_t *_parent, uint _idx)
+{
+	_bpt_node_t *_child = _parent->_children[_idx];
+	_bpt_node_t *_right = _alloc_node(_child->_leaf);
+	uint _old_n = _child->_n;
+	uint _sep;
+	uint _i;
+
+	if (_child->_leaf) {
+		uint _keep = BPT_NODE_KEYS / 2;
+		_right->_n = _old_n - _keep;
+		memcpy(_right->_keys, &_child->_keys[_keep],
+		       _right->_n * sizeof(uint));
+		memcpy(_LEAF(_right)->_values, &_LEAF(_child)->_values[_keep],
+		       _right->_n * sizeof(void *));
+		_LEAF(_right)->_next = _LEAF(_child)->_next;
+		_LEAF(_child)->_next = _LEAF(_right);
+		_child->_n = _keep;
+		_sep = _right->_keys[0];
+	} else {
+		uint _mid = BPT_NODE_KEYS / 2;
+		_right->_n = _old_n - _mid - 1;
+		memcpy(_right->_keys, &_child->_keys[_mid + 1],
+		       _right->_n * sizeof(uint));
+		memcpy(_INNER(_right)->_children,
+		       &_INNER(_child)->_children[_mid + 1],
+		       (_right->_n + 1) * sizeof(_bpt_node_t *));
+		_child->_n = _mid;
+		_sep = _child->_keys[_mid];
+	}
+	_repad(_child, _old_n);
+
+	for (_i = _parent->_node._n; _i > _idx; _i--) {
+		_parent->_node._keys[_i] = _parent->_node._keys[_i - 1];
+		_parent->_children[_i + 1] = _parent->_children[_i];
+	}
+	_parent->_node._keys[_idx] = _sep;
+	_parent->_children[_idx + 1] = _right;
+	_parent->_node._n++;
+}
+
+// Inserts top-down, splitting every full node on the way so that a
+// split never has to climb back up.
+void bpt_insert(bpt_t *_bpt, uint _key, void *_value)
+{
+	_bpt_node_t *_node;
+	_bpt_leaf_t *_leaf;
+	uint _pos;
+	uint _i;
+
+	if (_bpt->_root == NULL) {
+		_bpt->_root = _alloc_node(true);
+		_bpt->_height = 1;
+	}
+	if (_bpt->_root->_n == BPT_NODE_KEYS) {
+		_bpt_inner_t *_root = _alloc_node(false);
+		_root->_children[0] = _bpt->_root;
+		_split_child(_root, 0);
+		_bpt->_root = &_root->_node;
+		_bpt->_height++;
+	}
+
+	_node = _bpt->_root;
+	while (!_node->_leaf) {
+		uint _idx = _count_less_equal(_node, _key);
+		if (_INNER(_node)->_children[_idx]->_n == BPT_NODE_KEYS) {
+			_split_child(_INNER(_node), _idx);
+			if (_key >= _node->_keys[_idx]) {
+				_idx++;
+			}
+		}
+		_node = _INNER(_node)->_children[_idx];
+	}
+
+	_leaf = _LEAF(_node);
+	_pos = _count_less(_node, _key);
+	if (_pos < _node->_n && _node->_keys[_pos] == _key) {
+		fprintf(stderr, "ERROR: Redundant key (%u) value "
+			"found while inserting!\n", _key);
+		assert(false);
+	}
+	for (_i = _node->_n; _i > _pos; _i--) {
+		_node->_keys[_i] = _node->_keys[_i - 1];
+		_leaf->_values[_i] = _leaf->_values[_i - 1];
+	}
+	_node->_keys[_pos] = _key;
+	_leaf->_values[_pos] = _value;
+	_node->_n++;
+	_bpt->_size++;
+}
+
+// Moves the last entry of the left sibling of child _idx into it.
+static void _borrow_left(_bpt_inner_t *_parent, uint _idx)
+{
+	_bpt_node_t *_child = _parent->_children[_idx];
+	_bpt_node_t *_left = _parent->_children[_idx - 1];
+	uint _i;
+
+	for (_i = _child->_n; _i > 0; _i--) {
+		_child->_keys[_i] = _child->_keys[_i - 1];
+	}
+	if (_child->_leaf) {
+		for (_i = _child->_n; _i > 0; _i--) {
+			_LEAF(_child)->_values[_i] = _LEAF(_child)->_values[_i - 1];
+		}
+		_child->_keys[0] = _left->_keys[_left->_n - 1];
+		_LEAF(_child)->_values[0] = _LEAF(_left)->_values[_left->_n - 1];
+		_parent->_node._keys[_idx - 1] = _child->_keys[0];
+	} else {
+		for (_i = _child->_n + 1; _i > 0; _i--) {
+			_INNER(_child)->_children[_i] =
+				_INNER(_child)->_children[_i - 1];
+		}
+		_child->_keys[0] = _parent->_node._keys[_idx - 1];
+		_INNER(_child)->_children[0] =
+			_INNER(_left)->_children[_left->_n];
+		_parent->_node._keys[_idx - 1] = _left->_keys[_left->_n - 1];
+	}
+	_child->_n++;
+	_left->_n--;
+	_left->_keys[_left->_n] = _BPT_PAD;
+}
+
+// Moves the first entry of the right sibling of child _idx into it.
+static void _borrow_right(_bpt_inner_t *_parent, uint _idx)
+{
+	_bpt_node_t *_child = _parent->_children[_idx];
+	_bpt_node_t *_right = _parent->_children[_idx + 1];
+	uint _i;
+
+	if (_child->_leaf) {
+		_child->_keys[_child->_n] = _right->_keys[0];
+		_LEAF(_child)->_values[_child->_n] = _LEAF(_right)->_values[0];
+		for (_i = 1; _i < _right->_n; _i++) {
+			_right->_keys[_i - 1] = _right->_keys[_i];
+			_LEAF(_right)->_values[_i - 1] = _LEAF(_right)->_values[_i];
+		}
+		_parent->_node._keys[_idx] = _right->_keys[0];
+	} else {
+		_child->_keys[_child->_n] = _parent->_node._keys[_idx];
+		_INNER(_child)->_children[_child->_n + 1] =
+			_INNER(_right)->_children[0];
+		_parent->_node._keys[_idx] = _right->_keys[0];
+		for (_i = 1; _i < _right->_n; _i++) {
+			_right->_keys[_i - 1] = _right->_keys[_i];
+		}
+		for (_i = 1; _i <= _right->_n; _i++) {
+			_INNER(_right)->_children[_i - 1] =
+				_INNER(_right)->_children[_i];
+		}
+	}
+	_child->_n++;
+	_right->_n--;
+	_right->_keys[_right->_n] = _BPT_PAD;
+}
+
+// Merges child _idx + 1 of _parent into child _idx and frees it.
+static void _merge(_bpt_inner_t *_parent, uint _idx)
+{
+	_bpt_node_t *_left = _parent->_children[_idx];
+	_bpt_node_t *_right = _parent->_children[_idx + 1];
+	uint _i;
+
+	if (_left->_leaf) {
+		memcpy(&_left->_keys[_left->_n], _right->_keys,
+		       _right->_n * sizeof(uint));
+		memcpy(&_LEAF(_left)->_values[_left->_n], _LEAF(_right)->_values,
+		       _right->_n * sizeof(void *));
+		_left->_n += _right->_n;
+		_LEAF(_left)->_next = _LEAF(_right)->_next;
+	} else {
+		_left->_keys[_left->_n] = _parent->_node._keys[_idx];
+		memcpy(&_left->_keys[_left->_n + 1], _right->_keys,
+		       _right->_n * sizeof(uint));
+		memcpy(&_INNER(_left)->_children[_left->_n + 1],
+		       _INNER(_right)->_children,
+		       (_right->_n + 1) * sizeof(_bpt_node_t *));
+		_left->_n += _right->_n + 1;
+	}
+	free(_right);
+
+	for (_i = _idx + 1; _i < _parent->_node._n; _i++) {
+		_parent->_node._keys[_i - 1] = _parent->_node._keys[_i];
+		_parent->_children[_i] = _parent->_children[_i + 1];
+	}
+	_parent->_node._n--;
+	_parent->_node._keys[_parent->_node._n] = _BPT_PAD;
+}
+
+// Deletes top-down, topping up every child below BPT_MIN_KEYS + 1 keys
+// before entering it so that removing one key never underflows.
+void bpt_delete(bpt_t *_bpt, uint _key)
+{
+	_bpt_node_t *_node = _bpt->_root;
+	_bpt_leaf_t *_leaf;
+	uint _pos;
+	uint _i;
+
+	assert(_node != NULL);
+
+	while (!_node->_leaf) {
+		_bpt_inner_t *_inner = _INNER(_node);
+		uint _idx = _count_less_equal(_node, _key);
+
+		if (_inner->_children[_idx]->_n <= BPT_MIN_KEYS) {
+			if (_idx > 0 &&
+			    _inner->_children[_idx - 1]->_n > BPT_MIN_KEYS) {
+				_borrow_left(_inner, _idx);
+			} else if (_idx < _node->_n &&
+				   _inner->_children[_idx + 1]->_n > BPT_MIN_KEYS) {
+				_borrow_right(_inner, _idx);
+			} else if (_idx > 0) {
+				_merge(_inner, --_idx);
+			} else {
+				_merge(_inner, _idx);
+			}
+		}
+		if (_node->_n == 0) {
+			// The root lost its last key to a merge.
+			assert(_node == _bpt->_root);
+			_bpt->_root = _inner->_children[0];
+			_bpt->_height--;
+			free(_node);
+			_node = _bpt->_root;
+			continue;
+		}
+		_node = _inner->_children[_idx];
+	}
+
+	_leaf = _LEAF(_node);
+	_pos = _count_less(_node, _key);
+	assert(_pos < _node->_n && _node->_keys[_pos] == _key);
+
+	for (_i = _pos + 1; _i < _node->_n; _i++) {
+		_node->_keys[_i - 1] = _node->_keys[_i];
+		_leaf->_values[_i - 1] = _leaf->_values[_i];
+	}
+	_node->_n--;
+	_node->_keys[_node->_n] = _BPT_PAD;
+	_bpt->_size--;
+
+	if (_bpt->_size == 0) {
+		free(_bpt->_root);
+		bpt_init(_bpt);
+	}
+}
+
+bpt_itr_t bpt_get_itr(bpt_t *_bpt)
+{
+	bpt_itr_t _itr = { NULL, 0 };
+	_bpt_node_t *_node = _bpt->_root;
+
+	if (_node == NULL || _bpt->_size == 0) {
+		return _itr;
+	}
+	while (!_node->_leaf) {
+		_node = _INNER(_node)->_children[0];
+	}
+	_itr._leaf = _LEAF(_node);
+	return _itr;
+}
+
+// Returns the first entry with a key >= _key, or the end.
+bpt_itr_t bpt_lower_bound(bpt_t *_bpt, uint _key)
+{
+	bpt_itr_t _itr = { _find_leaf(_bpt, _key), 0 };
+
+	if (_itr._leaf == NULL) {
+		return _itr;
+	}
+	_itr._pos = _count_less(&_itr._leaf->_node, _key);
+	if (_itr._pos == _itr._leaf->_node._n) {
+		// Leaves other than the root are never empty.
+		_itr._leaf = _itr._leaf->_next;
+		_itr._pos = 0;
+	}
+	return _itr;
+}
+
+bpt_itr_t bpt_iter_next(bpt_itr_t _itr)
+{
+	if (++_itr._pos == _itr._leaf->_node._n) {
+		_itr._leaf = _itr._leaf->_next;
+		_itr._pos = 0;
+	}
+	return _itr;
+}
+
+bool bpt_iter_end(bpt_itr_t _itr)
+{
+	return _itr._leaf == NULL;
+}
+
+uint bpt_iter_key(bpt_itr_t _itr)
+{
+	return _itr._leaf->_node._keys[_itr._pos];
+}
+
+void *bpt_iter_value(bpt_itr_t _itr)
+{
+	return _itr._leaf->_values[_itr._pos];
+}
+
+// Calls _callback on every entry with _lo <= key <= _hi in key order
+// and returns how many entries were visited.  The walk follows the leaf
+// chain, so only the first leaf costs a descent.
+size_t bpt_range(bpt_t *_bpt, uint _lo, uint _hi,
+		 avlt_range_cb_t _callback, void *_arg)
+{
+	size_t _cnt = 0;
+	bpt_itr_t _itr = bpt_lower_bound(_bpt, _lo);
+
+	while (!bpt_iter_end(_itr) && bpt_iter_key(_itr) <= _hi) {
+		_cnt++;
+		if (_callback(bpt_iter_key(_itr), bpt_iter_value(_itr),
+			      _arg) != 0) {
+			break;
+		}
+		_itr = bpt_iter_next(_itr);
+	}
+	return _cnt;
+}
@@ -0,0 +1,84 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_bpt.h
+
+C-based B+-tree with the operations of c_avlt.h.  Nodes
+hold BPT_NODE_KEYS sorted keys in whole cache lines, so a
+lookup takes a few cache misses per level instead of one
+per comparison, and the keys of a node are searched with
+SSE2 where available.  Leaves are chained for ordered scans.
+
+Entries move between leaves on splits and merges, so unlike
+avlt_itr_t a bpt_itr_t is only valid until the next insert
+or delete.
+
+\**************************************************/
+
+#ifndef __C_BPT_H__
+#define __C_BPT_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "c_avlt.h"	// avlt_range_cb_t
+
+// Keys per node, a multiple of 4 so that SSE2 compares never straddle
+// the end of _keys.  32 keys fill two cache lines.
+#ifndef BPT_NODE_KEYS
+#define BPT_NODE_KEYS (32)
+#endif
+// Nodes other than the root keep at least this many keys.
+#define BPT_MIN_KEYS (BPT_NODE_KEYS / 2 - 1)
+#define BPT_CACHE_LINE (64)
+
+// Slots past _n hold _BPT_PAD, which never compares below a key.
+#define _BPT_PAD UINT32_MAX
+
+typedef struct _bpt_node {
+	uint _keys[BPT_NODE_KEYS];
+	uint _n;		// keys in use
+	bool _leaf;
+} _bpt_node_t;
+
+// _children[i] holds keys in [_keys[i - 1], _keys[i]).
+typedef struct _bpt_inner {
+	_bpt_node_t _node;
+	_bpt_node_t *_children[BPT_NODE_KEYS + 1];
+} _bpt_inner_t;
+
+typedef struct _bpt_leaf {
+	_bpt_node_t _node;
+	void *_values[BPT_NODE_KEYS];
+	struct _bpt_leaf *_next;
+} _bpt_leaf_t;
+
+typedef struct c_bpt {
+	_bpt_node_t *_root;
+	size_t _size;
+	uint _height;		// levels, 0 for an empty tree
+} bpt_t;
+
+// An entry is (_leaf, _pos); _leaf is NULL at the end.
+typedef struct bpt_itr {
+	_bpt_leaf_t *_leaf;
+	uint _pos;
+} bpt_itr_t;
+
+void bpt_init(bpt_t *_bpt);
+void bpt_destroy(bpt_t *_bpt);
+void *bpt_search(bpt_t *_bpt, uint _key);
+void bpt_insert(bpt_t *_bpt, uint _key, void *_value);
+void bpt_delete(bpt_t *_bpt, uint _key);
+size_t bpt_range(bpt_t *_bpt, uint _lo, uint _hi,
+		 avlt_range_cb_t _callback, void *_arg);
+bpt_itr_t bpt_get_itr(bpt_t *_bpt);
+bpt_itr_t bpt_lower_bound(bpt_t *_bpt, uint _key);
+bpt_itr_t bpt_iter_next(bpt_itr_t _itr);
+bool bpt_iter_end(bpt_itr_t _itr);
+uint bpt_iter_key(bpt_itr_t _itr);
+void *bpt_iter_value(bpt_itr_t _itr);
+
+#endif  // end of #ifndef __C_BPT_H__
@@ -15,12 +15,242 @@ void dq_initialize(dq_t *_dq) {
 }
 
 
+// The deque whose cache _dq's nodes go through, or NULL when the cache
+// holds nodes of the other size.
+static inline dq_t *_cache_of(dq_t *_dq)
+{
+	dq_t *_owner = (_dq->_cache_owner != NULL) ? _dq->_cache_owner : _dq;
+	return (_owner->_indexed == _dq->_indexed) ? _owner : NULL;
+}
+
+
+static inline _dq_node_t *_alloc_node(dq_t *_dq, void *_data)
+{
+	dq_t *_cache = _cache_of(_dq);
+	_dq_node_t *_node = NULL;
+	if (_cache != NULL && _cache->_cache != NULL) {
+		_node = _cache->_cache;
+		_cache->_cache = _node->_next;
+		_cache->_cached--;
+	} else {
+		_node = (_dq_node_t *) malloc(_dq->_indexed ?
+					      sizeof(_dq_inode_t) :
+					      sizeof(_dq_node_t));
+		assert(_node != NULL);
+	}
+	_node->_next = NULL;
+	_node->_prev = NULL;
+	_node->_data = _data;
+	return _node;
+}
+
+
+static inline void _free_node(dq_t *_dq, _dq_node_t *_node)
+{
+	dq_t *_cache = _cache_of(_dq);
+	if (_cache != NULL && _cache->_caching &&
+	    _cache->_cached < DQ_NODE_CACHE) {
+		_node->_next = _cache->_cache;
+		_cache->_cache = _node;
+		_cache->_cached++;
+	} else {
+		free(_node);
+	}
+}
+
+
+static inline size_t _count(_dq_inode_t *_inode)
+{
+	return (_inode != NULL) ? _inode->_count : 0;
+}
+
+
+static inline void _update_count(_dq_inode_t *_inode)
+{
+	_inode->_count = 1 + _count(_inode->_left) + _count(_inode->_right);
+}
+
+
+static inline void _replace_child(dq_t *_dq, _dq_inode_t *_parent,
+				  _dq_inode_t *_old, _dq_inode_t *_new)
+{
+	if (_parent == NULL) {
+		_dq->_root = _new;
+	} else if (_parent->_left == _old) {
+		_parent->_left = _new;
+	} else {
+		_parent->_right = _new;
+	}
+}
+
+
+// Rotates _inode above its parent, keeping list order.
+static void _rotate_up(dq_t *_dq, _dq_inode_t *_inode)
+{
+	_dq_inode_t *_parent = _inode->_parent;
+	_dq_inode_t *_grand_parent = _parent->_parent;
+
+	if (_parent->_left == _inode) {
+		_parent->_left = _inode->_right;
+		if (_parent->_left != NULL) {
+			_parent->_left->_parent = _parent;
+		}
+		_inode->_right = _parent;
+	} else {
+		_parent->_right = _inode->_left;
+		if (_parent->_right != NULL) {
+			_parent->_right->_parent = _parent;
+		}
+		_inode->_left = _parent;
+	}
+	_parent->_parent = _inode;
+	_inode->_parent = _grand_parent;
+	_replace_child(_dq, _grand_parent, _parent, _inode);
+	_update_count(_parent);
+	_update_count(_inode);
+}
+
+
+static inline uint64_t _next_prio(dq_t *_dq)
+{
+	uint64_t _x = _dq->_seed;
+	_x ^= _x >> 12;
+	_x ^= _x << 25;
+	_x ^= _x >> 27;
+	_dq->_seed = _x;
+	return _x * 0x2545F4914F6CDD1DULL;
+}
+
+
+static _dq_inode_t *_index_select(dq_t *_dq, size_t _index)
+{
+	_dq_inode_t *_inode = _dq->_root;
+	for (;;) {
+		size_t _left = _count(_inode->_left);
+		if (_index < _left) {
+			_inode = _inode->_left;
+		} else if (_index == _left) {
+			return _inode;
+		} else {
+			_index -= _left + 1;
+			_inode = _inode->_right;
+		}
+	}
+}
+
+
+// Adds _inode to the treap as the node at position _pos: down to a leaf
+// slot, counting it on the way, then up by priority.
+static void _index_insert(dq_t *_dq, _dq_inode_t *_inode, size_t _pos)
+{
+	_dq_inode_t *_parent = _dq->_root;
+
+	_inode->_left = NULL;
+	_inode->_right = NULL;
+	_inode->_parent = NULL;
+	_inode->_count = 1;
+	_inode->_prio = _next_prio(_dq);
+	if (_parent == NULL) {
+		_dq->_root = _inode;
+		return;
+	}
+	for (;;) {
+		_parent->_count++;
+		if (_pos <= _count(_parent->_left)) {
+			if (_parent->_left == NULL) {
+				_parent->_left = _inode;
+				break;
+			}
+			_parent = _parent->_left;
+		} else {
+			_pos -= _count(_parent->_left) + 1;
+			if (_parent->_right == NULL) {
+				_parent->_right = _inode;
+				break;
+			}
+			_parent = _parent->_right;
+		}
+	}
+	_inode->_parent = _parent;
+	while (_inode->_parent != NULL && _inode->_parent->_prio < _inode->_prio) {
+		_rotate_up(_dq, _inode);
+	}
+}
+
+
+// Rotates _inode down until it has at most one child, then splices it
+// out and uncounts it on the way to the root.
+static void _index_remove(dq_t *_dq, _dq_inode_t *_inode)
+{
+	_dq_inode_t *_child;
+	_dq_inode_t *_parent;
+
+	while (_inode->_left != NULL && _inode->_right != NULL) {
+		_rotate_up(_dq, (_inode->_left->_prio > _inode->_right->_prio) ?
+			   _inode->_left : _inode->_right);
+	}
+	_child = (_inode->_left != NULL) ? _inode->_left : _inode->_right;
+	if (_child != NULL) {
+		_child->_parent = _inode->_parent;
+	}
+	_replace_child(_dq, _inode->_parent, _inode, _child);
+	for (_parent = _inode->_parent; _parent != NULL;
+	     _parent = _parent->_parent) {
+		_parent->_count--;
+	}
+}
+
+
+// Joins two treaps, every node of _a before every node of _b.
+static _dq_inode_t *_index_merge(_dq_inode_t *_a, _dq_inode_t *_b)
+{
+	if (_a == NULL) {
+		return _b;
+	}
+	if (_b == NULL) {
+		return _a;
+	}
+	if (_a->_prio > _b->_prio) {
+		_a->_right = _index_merge(_a->_right, _b);
+		_a->_right->_parent = _a;
+		_update_count(_a);
+		return _a;
+	}
+	_b->_left = _index_merge(_a, _b->_left);
+	_b->_left->_parent = _b;
+	_update_count(_b);
+	return _b;
+}
+
+
+// Finds the node at _index from the nearer end of the list, or through
+// the treap of an indexed deque.
+static _dq_node_t *_node_at(dq_t *_dq, size_t _index)
+{
+	size_t _i;
+	_dq_node_t *_curr_node;
+
+	if (_dq->_indexed) {
+		return &_index_select(_dq, _index)->_node;
+	}
+	if (_index < _dq->_size / 2) {
+		_curr_node = _dq->_front;
+		for (_i = 0; _i < _index; _i++) {
+			_curr_node = _curr_node->_next;
+		}
+	} else {
+		_curr_node = _dq->_back;
+		for (_i = _dq->_size - 1; _i > _index; _i--) {
+			_curr_node = _curr_node->_prev;
+		}
+	}
+	return _curr_node;
+}
+
+
 dq_itr_t dq_push_front(dq_t *_dq, void *_data)
 {
-	_dq_node_t *_new_node = (_dq_node_t *) malloc(sizeof(_dq_node_t));
-	assert(_new_node != NULL);
-	memset(_new_node, 0, sizeof(_dq_node_t));
-	_new_node->_data = _data;
+	_dq_node_t *_new_node = _alloc_node(_dq, _data);
 	if (_dq->_size == 0) {
 		assert(_dq->_back == NULL && _dq->_front == NULL);
 		_dq->_front = _new_node;
@@ -31,6 +261,9 @@ dq_itr_t dq_push_front(dq_t *_dq, void *_data)
 		_new_node->_next = _dq->_front;
 		_dq->_front = _new_node;
 	}
+	if (_dq->_indexed) {
+		_index_insert(_dq, (_dq_inode_t *) _new_node, 0);
+	}
 	_dq->_size++;
 	return _new_node;
 }
@@ -38,10 +271,7 @@ dq_itr_t dq_push_front(dq_t *_dq, void *_data)
 
 dq_itr_t dq_push_back(dq_t *_dq, void *_data)
 {
-	_dq_node_t *_new_node = (_dq_node_t *) malloc(sizeof(_dq_node_t));
-	assert(_new_node != NULL);
-	memset(_new_node, 0, sizeof(_dq_node_t));
-	_new_node->_data = _data;
+	_dq_node_t *_new_node = _alloc_node(_dq, _data);
 	if (_dq->_size == 0) {
 		assert(_dq->_back == NULL && _dq->_front == NULL);
 		_dq->_front = _new_node;
@@ -52,6 +282,9 @@ dq_itr_t dq_push_back(dq_t *_dq, void *_data)
 		_new_node->_prev = _dq->_back;
 		_dq->_back = _new_node;
 	}
+	if (_dq->_indexed) {
+		_index_insert(_dq, (_dq_inode_t *) _new_node, _dq->_size);
+	}
 	_dq->_size++;
 
 	return _new_node;
@@ -75,7 +308,10 @@ void *dq_pop_front(dq_t *_dq)
 		_dq->_back = NULL;
 	}
 	_dq->_size--;
-	free(_pop_node);
+	if (_dq->_indexed) {
+		_index_remove(_dq, (_dq_inode_t *) _pop_node);
+	}
+	_free_node(_dq, _pop_node);
 	return _return_data;
 }
 
@@ -97,7 +333,10 @@ void *dq_pop_back(dq_t *_dq)
 		_dq->_front = NULL;
 	}
 	_dq->_size--;
-	free(_pop_node);
+	if (_dq->_indexed) {
+		_index_remove(_dq, (_dq_inode_t *) _pop_node);
+	}
+	_free_node(_dq, _pop_node);
 	return _return_data;
 }
 
@@ -149,12 +388,7 @@ void *dq_at(dq_t *_dq, size_t _index)
 			"out of bound index!n");
 		exit(EXIT_FAILURE);
 	}
-	size_t _i;
-	_dq_node_t *_curr_node = _dq->_front;
-	for (_i = 0; _i < _index; _i++) {
-		_curr_node = _curr_node->_next;
-	}
-	return _curr_node->_data;
+	return _node_at(_dq, _index)->_data;
 }
 
 
@@ -166,23 +400,18 @@ void dq_insert_at(dq_t *_dq, size_t _index, void *_data)
 	} else if (_index == _dq->_size) {
 		dq_push_back(_dq, _data);
 	} else {
-		size_t _i;
 		_dq_node_t *_curr_node;
-		_dq_node_t *_new_node = (_dq_node_t *)
-			malloc(sizeof(_dq_node_t));
-		assert(_new_node != NULL);
-		memset(_new_node, 0, sizeof(_dq_node_t));
-		_new_node->_data = _data;
+		_dq_node_t *_new_node = _alloc_node(_dq, _data);
 		_dq_node_t *_prev_node;
-		_curr_node = _dq->_front;
-		for (_i = 0; _i < _index; _i++) {
-			_curr_node = _curr_node->_next;
-		}
+		_curr_node = _node_at(_dq, _index);
 		_prev_node = _curr_node->_prev;
 		_curr_node->_prev = _new_node;
 		_prev_node->_next = _new_node;
 		_new_node->_prev = _prev_node;
 		_new_node->_next = _curr_node;
+		if (_dq->_indexed) {
+			_index_insert(_dq, (_dq_inode_t *) _new_node, _index);
+		}
 		_dq->_size++;
 	}
 }
@@ -202,27 +431,31 @@ void *dq_erase_at(dq_t *_dq, size_t _index)
 	} else if (_index == _dq->_size - 1) {
 		_return_data = dq_pop_back(_dq);
 	} else {
-		size_t _i;
-		_dq_node_t *_erase_node = _dq->_front;
+		_dq_node_t *_erase_node = _node_at(_dq, _index);
 		_dq_node_t *_prev_node;
 		_dq_node_t *_next_node;
-		for (_i = 0; _i < _index; _i++) {
-			_erase_node = _erase_node->_next;
-		}
 		_return_data = _erase_node->_data;
 		_prev_node = _erase_node->_prev;
 		_next_node = _erase_node->_next;
 		_prev_node->_next = _next_node;
 		_next_node->_prev = _prev_node;
-		free(_erase_node);
+		if (_dq->_indexed) {
+			_index_remove(_dq, (_dq_inode_t *) _erase_node);
+		}
+		_free_node(_dq, _erase_node);
 		_dq->_size--;
 	}
 	return _return_data;
 }
 
 
+// Frees every node, the node cache included, and stops sharing the
+// cache of another deque.  An indexed or caching deque stays so.
 void dq_clear(dq_t *_dq)
 {
+	bool _caching = _dq->_caching;
+	bool _indexed = _dq->_indexed;
+	uint64_t _seed = _dq->_seed;
 	size_t _cnt = 0;
 	_dq_node_t *_curr_node = _dq->_front;
 	_dq_node_t *_prev_node;
@@ -233,9 +466,117 @@ void dq_clear(dq_t *_dq)
 		_cnt++;
 	}
 	assert(_cnt == _dq->_size);
-	_dq->_front = NULL;
-	_dq->_back = NULL;
-	_dq->_size = 0;
+	_curr_node = _dq->_cache;
+	while (_curr_node != NULL) {
+		_prev_node = _curr_node;
+		_curr_node = _curr_node->_next;
+		free(_prev_node);
+	}
+	dq_initialize(_dq);
+	_dq->_caching = _caching;
+	_dq->_indexed = _indexed;
+	_dq->_seed = _seed;
+}
+
+
+// Appends _n items in order, linking them into a chain before hooking
+// the chain onto the back once.
+void dq_push_back_n(dq_t *_dq, void * const *_data, size_t _n)
+{
+	_dq_node_t *_first;
+	_dq_node_t *_last;
+	size_t _i;
+
+	if (_n == 0) {
+		return;
+	}
+	_first = _alloc_node(_dq, _data[0]);
+	_last = _first;
+	for (_i = 1; _i < _n; _i++) {
+		_dq_node_t *_new_node = _alloc_node(_dq, _data[_i]);
+		_new_node->_prev = _last;
+		_last->_next = _new_node;
+		_last = _new_node;
+	}
+	if (_dq->_size == 0) {
+		_dq->_front = _first;
+	} else {
+		_dq->_back->_next = _first;
+		_first->_prev = _dq->_back;
+	}
+	_dq->_back = _last;
+	if (_dq->_indexed) {
+		for (_i = 0; _i < _n; _i++) {
+			_index_insert(_dq, (_dq_inode_t *) _first, _dq->_size + _i);
+			_first = _first->_next;
+		}
+	}
+	_dq->_size += _n;
+}
+
+
+// Pops up to _n items from the front into _out and returns how many
+// were popped.
+size_t dq_pop_front_n(dq_t *_dq, void **_out, size_t _n)
+{
+	_dq_node_t *_pop_node;
+	size_t _i;
+
+	if (_n > _dq->_size) {
+		_n = _dq->_size;
+	}
+	for (_i = 0; _i < _n; _i++) {
+		_pop_node = _dq->_front;
+		_out[_i] = _pop_node->_data;
+		_dq->_front = _pop_node->_next;
+		if (_dq->_indexed) {
+			_index_remove(_dq, (_dq_inode_t *) _pop_node);
+		}
+		_free_node(_dq, _pop_node);
+	}
+	_dq->_size -= _n;
+	if (_dq->_size == 0) {
+		_dq->_front = NULL;
+		_dq->_back = NULL;
+	} else {
+		_dq->_front->_prev = NULL;
+	}
+	return _n;
+}
+
+
+// Moves every item of _src onto the back of _dst in O(1), or O(log n)
+// expected when indexed.  _src ends up empty, and handles into _src
+// stay valid and now belong to _dst.  Nodes then return to _dst's
+// cache, if any, so deques that pass items along should share one
+// cache with dq_share_cache().
+void dq_splice(dq_t *_dst, dq_t *_src)
+{
+	assert(_dst != _src);
+	if (_src->_size == 0) {
+		return;
+	}
+	if (_dst->_indexed != _src->_indexed) {
+		fprintf(stderr, "ERROR: Attempt to splice deques with "
+			"different node types!\n");
+		exit(EXIT_FAILURE);
+	}
+	if (_dst->_indexed) {
+		_dst->_root = _index_merge(_dst->_root, _src->_root);
+		_dst->_root->_parent = NULL;
+		_src->_root = NULL;
+	}
+	if (_dst->_size == 0) {
+		_dst->_front = _src->_front;
+	} else {
+		_dst->_back->_next = _src->_front;
+		_src->_front->_prev = _dst->_back;
+	}
+	_dst->_back = _src->_back;
+	_dst->_size += _src->_size;
+	_src->_front = NULL;
+	_src->_back = NULL;
+	_src->_size = 0;
 }
 
 
@@ -256,7 +597,10 @@ void *dq_erase(dq_t *_dq, dq_itr_t _dq_itr)
 		_next_node = _erase_node->_next;
 		_prev_node->_next = _next_node;
 		_next_node->_prev = _prev_node;
-		free(_erase_node);
+		if (_dq->_indexed) {
+			_index_remove(_dq, (_dq_inode_t *) _erase_node);
+		}
+		_free_node(_dq, _erase_node);
 		_dq->_size--;
 	}
 	return _return_data;
@@ -273,3 +617,83 @@ dq_itr_t dq_itr_move_next(dq_itr_t _dq_itr)
 {
 	return _dq_itr->_next;
 }
+
+
+// Makes popped and erased nodes wait in a cache of up to DQ_NODE_CACHE
+// nodes for the next push instead of going back to free().  The cache
+// outlives the items, so a deque that caches owns memory even when
+// empty and must be released with dq_clear().
+void dq_enable_cache(dq_t *_dq)
+{
+	_dq->_caching = true;
+}
+
+
+// Makes _dq take nodes from and return nodes to the cache of _owner,
+// so that nodes moved between the two by dq_splice() keep getting
+// reused instead of draining one cache and overflowing the other.
+// Nodes are only kept if _owner called dq_enable_cache().  _owner must
+// not share another deque's cache and must outlive _dq.
+void dq_share_cache(dq_t *_dq, dq_t *_owner)
+{
+	assert(_owner->_cache_owner == NULL && _dq != _owner);
+	_dq->_cache_owner = _owner;
+}
+
+
+// Makes positional access, dq_insert_at() and dq_erase_at() O(log n)
+// expected, at the price of larger nodes and O(log n) pushes and pops.
+// Nodes are allocated with room for the index, which is why it can only
+// be turned on while the deque is empty; dq_itr_t handles work as
+// before.
+void dq_enable_index(dq_t *_dq)
+{
+	_dq_node_t *_curr_node;
+
+	if (_dq->_size != 0) {
+		fprintf(stderr, "ERROR: Index can only be enabled on an "
+			"empty deque!\n");
+		exit(EXIT_FAILURE);
+	}
+	if (_dq->_indexed) {
+		return;
+	}
+	// Cached nodes are too small for the index.
+	while (_dq->_cache != NULL) {
+		_curr_node = _dq->_cache;
+		_dq->_cache = _curr_node->_next;
+		free(_curr_node);
+	}
+	_dq->_cached = 0;
+	_dq->_indexed = true;
+	_dq->_seed = 0x9E3779B97F4A7C15ULL ^ (uintptr_t) _dq;
+	if (_dq->_seed == 0) {
+		_dq->_seed = 1;
+	}
+}
+
+
+// Returns the position of _dq_itr in _dq, in O(log n) expected when
+// indexed and by walking the list otherwise.
+size_t dq_index_of(dq_t *_dq, dq_itr_t _dq_itr)
+{
+	_dq_inode_t *_inode = (_dq_inode_t *) _dq_itr;
+	size_t _index = 0;
+
+	if (!_dq->_indexed) {
+		_dq_node_t *_curr_node;
+		for (_curr_node = _dq_itr->_prev; _curr_node != NULL;
+		     _curr_node = _curr_node->_prev) {
+			_index++;
+		}
+		return _index;
+	}
+	_index = _count(_inode->_left);
+	while (_inode->_parent != NULL) {
+		if (_inode->_parent->_right == _inode) {
+			_index += _count(_inode->_parent->_left) + 1;
+		}
+		_inode = _inode->_parent;
+	}
+	return _index;
+}
@@ -27,10 +27,35 @@ typedef struct c_deque_node {
 
 typedef _dq_node_t * dq_itr_t;
 
+// Node of an indexed deque.  Besides the list links, nodes form a treap
+// in list order whose subtree counts give the position of every node,
+// so positional access, insert and erase take O(log n) expected.
+typedef struct c_deque_inode {
+	_dq_node_t _node;	// first, so that a dq_itr_t points at it
+	struct c_deque_inode *_left;
+	struct c_deque_inode *_right;
+	struct c_deque_inode *_parent;
+	size_t _count;		// nodes in this subtree
+	uint64_t _prio;		// treap heap order, larger on top
+} _dq_inode_t;
+
+// Freed nodes kept for reuse, chained through _next, by a deque that
+// called dq_enable_cache().
+#ifndef DQ_NODE_CACHE
+#define DQ_NODE_CACHE (4096)
+#endif
+
 typedef struct c_deque {
 	_dq_node_t *_front;
 	_dq_node_t *_back;
 	size_t _size;
+	bool _caching;		// see dq_enable_cache()
+	_dq_node_t *_cache;
+	size_t _cached;
+	struct c_deque *_cache_owner;	// deque whose cache is used, or NULL
+	bool _indexed;		// see dq_enable_index()
+	_dq_inode_t *_root;	// treap over the nodes when _indexed
+	uint64_t _seed;		// treap priorities
 } dq_t;
 
 
@@ -46,6 +71,13 @@ void *dq_at(dq_t *_dq, size_t _index);
 void dq_insert_at(dq_t *_dq, size_t _index, void *_data);
 void *dq_erase_at(dq_t *_dq, size_t _index);
 void dq_clear(dq_t *_dq);
+void dq_push_back_n(dq_t *_dq, void * const *_data, size_t _n);
+size_t dq_pop_front_n(dq_t *_dq, void **_out, size_t _n);
+void dq_splice(dq_t *_dst, dq_t *_src);
+void dq_enable_cache(dq_t *_dq);
+void dq_share_cache(dq_t *_dq, dq_t *_owner);
+void dq_enable_index(dq_t *_dq);
+size_t dq_index_of(dq_t *_dq, dq_itr_t _dq_itr);
 void dq_print(dq_t *_dq, FILE *_fp);
 
 dq_itr_t dq_get_itr(dq_t *_dq);
@@ -0,0 +1,193 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_mpmcq.c
+
+Multi-producer multi-consumer ring implementation.
+
+\**************************************************/
+
+#include "c_mpmcq.h"
+
+#include <assert.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+static inline void _cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#endif
+}
+
+// Backs off after a failed try: a pause while _spins is small, then
+// the rest of the time slice.
+static inline void _backoff(size_t *_spins)
+{
+	if (++*_spins < MPMCQ_SPINS) {
+		_cpu_relax();
+	} else {
+		sched_yield();
+	}
+}
+
+// Rounds _capacity up to a power of two, at least 2.
+void mpmcq_init(mpmcq_t *_q, size_t _capacity)
+{
+	size_t _cap = 2;
+	size_t _i;
+
+	while (_cap < _capacity) {
+		_cap *= 2;
+	}
+	memset(_q, 0, sizeof(mpmcq_t));
+	_q->_cells = (_mpmcq_cell_t *) malloc(_cap * sizeof(_mpmcq_cell_t));
+	if (_q->_cells == NULL) {
+		fprintf(stderr, "ERROR: mpmcq_init failed to allocate "
+			"%zu cells!\n", _cap);
+		exit(EXIT_FAILURE);
+	}
+	for (_i = 0; _i < _cap; _i++) {
+		_q->_cells[_i]._seq = _i;
+	}
+	_q->_mask = _cap - 1;
+}
+
+void mpmcq_destroy(mpmcq_t *_q)
+{
+	free(_q->_cells);
+	memset(_q, 0, sizeof(mpmcq_t));
+}
+
+size_t mpmcq_capacity(mpmcq_t *_q)
+{
+	return _q->_mask + 1;
+}
+
+// Exact only when no thread is using the queue.
+size_t mpmcq_size(mpmcq_t *_q)
+{
+	size_t _deq = __atomic_load_n(&_q->_deq, __ATOMIC_ACQUIRE);
+	size_t _enq = __atomic_load_n(&_q->_enq, __ATOMIC_ACQUIRE);
+	return (_enq > _deq) ? _enq - _deq : 0;
+}
+
+// Claims up to _n consecutive cells at the shared position *_pos whose
+// _seq equals position + _lag, with a single CAS.  Returns how many
+// cells were claimed from position *_start, or 0 when the cell at the
+// position is not ready (ring full for pushes, empty for pops).
+static size_t _claim(mpmcq_t *_q, size_t *_pos, size_t _lag, size_t _n,
+		     size_t *_start)
+{
+	size_t _at = __atomic_load_n(_pos, __ATOMIC_RELAXED);
+	size_t _cnt;
+
+	for (;;) {
+		_cnt = 0;
+		while (_cnt < _n) {
+			_mpmcq_cell_t *_cell = &_q->_cells[(_at + _cnt) &
+							   _q->_mask];
+			size_t _seq = __atomic_load_n(&_cell->_seq,
+						      __ATOMIC_ACQUIRE);
+			intptr_t _diff = (intptr_t) (_seq - (_at + _cnt + _lag));
+			if (_diff != 0) {
+				if (_cnt == 0 && _diff > 0) {
+					// Someone else took _at already.
+					_cnt = SIZE_MAX;
+				}
+				break;
+			}
+			_cnt++;
+		}
+		if (_cnt == 0) {
+			return 0;
+		}
+		if (_cnt == SIZE_MAX) {
+			_at = __atomic_load_n(_pos, __ATOMIC_RELAXED);
+			continue;
+		}
+		if (__atomic_compare_exchange_n(_pos, &_at, _at + _cnt, true,
+						__ATOMIC_RELAXED,
+						__ATOMIC_RELAXED)) {
+			*_start = _at;
+			return _cnt;
+		}
+		// _at now holds the current position; look again from there.
+	}
+}
+
+// Returns false if the queue is full.
+bool mpmcq_try_push(mpmcq_t *_q, void *_item)
+{
+	return mpmcq_try_push_n(_q, &_item, 1) == 1;
+}
+
+// Returns false if the queue is empty.
+bool mpmcq_try_pop(mpmcq_t *_q, void **_item)
+{
+	return mpmcq_try_pop_n(_q, _item, 1) == 1;
+}
+
+// Pushes the first k of _items, for the largest k <= _n whose cells are
+// free right now, and returns k.  The items stay in order, but pops may
+// see them before the push returns.
+size_t mpmcq_try_push_n(mpmcq_t *_q, void * const *_items, size_t _n)
+{
+	size_t _start;
+	size_t _cnt;
+	size_t _i;
+
+	if (_n == 0) {
+		return 0;
+	}
+	_cnt = _claim(_q, &_q->_enq, 0, _n, &_start);
+	for (_i = 0; _i < _cnt; _i++) {
+		_mpmcq_cell_t *_cell = &_q->_cells[(_start + _i) & _q->_mask];
+		_cell->_data = _items[_i];
+		__atomic_store_n(&_cell->_seq, _start + _i + 1,
+				 __ATOMIC_RELEASE);
+	}
+	return _cnt;
+}
+
+// Pops up to _n items that are ready right now into _items and returns
+// how many were popped.
+size_t mpmcq_try_pop_n(mpmcq_t *_q, void **_items, size_t _n)
+{
+	size_t _start;
+	size_t _cnt;
+	size_t _i;
+
+	if (_n == 0) {
+		return 0;
+	}
+	_cnt = _claim(_q, &_q->_deq, 1, _n, &_start);
+	for (_i = 0; _i < _cnt; _i++) {
+		_mpmcq_cell_t *_cell = &_q->_cells[(_start + _i) & _q->_mask];
+		_items[_i] = _cell->_data;
+		// Free the cell for the push one lap later.
+		__atomic_store_n(&_cell->_seq, _start + _i + _q->_mask + 1,
+				 __ATOMIC_RELEASE);
+	}
+	return _cnt;
+}
+
+void mpmcq_push(mpmcq_t *_q, void *_item)
+{
+	size_t _spins = 0;
+	while (!mpmcq_try_push(_q, _item)) {
+		_backoff(&_spins);
+	}
+}
+
+void *mpmcq_pop(mpmcq_t *_q)
+{
+	size_t _spins = 0;
+	void *_item;
+	while (!mpmcq_try_pop(_q, &_item)) {
+		_backoff(&_spins);
+	}
+	return _item;
+}
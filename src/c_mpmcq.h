@@ -0,0 +1,58 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_mpmcq.h
+
+Bounded lock-free ring of pointers for any number of
+producer and consumer threads (D. Vyukov's design).  Every
+cell carries a sequence number telling which lap of the ring
+may use it next, so a thread claims a cell with one CAS on
+the shared position and then works on the cell alone.
+
+\**************************************************/
+
+#ifndef __C_MPMCQ_H__
+#define __C_MPMCQ_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MPMCQ_CACHE_LINE (64)
+// Failed tries mpmcq_push() and mpmcq_pop() spin through before they
+// start yielding the CPU.
+#ifndef MPMCQ_SPINS
+#define MPMCQ_SPINS (128)
+#endif
+
+// A cell at ring position p is free for the push of p when _seq == p,
+// and holds the item for the pop of p when _seq == p + 1.
+typedef struct _mpmcq_cell {
+	size_t _seq;
+	void *_data;
+} _mpmcq_cell_t;
+
+typedef struct c_mpmcq {
+	size_t _enq __attribute__((aligned(MPMCQ_CACHE_LINE)));
+	size_t _deq __attribute__((aligned(MPMCQ_CACHE_LINE)));
+	// Read-only after mpmcq_init().
+	_mpmcq_cell_t *_cells __attribute__((aligned(MPMCQ_CACHE_LINE)));
+	size_t _mask;
+} __attribute__((aligned(MPMCQ_CACHE_LINE))) mpmcq_t;
+
+void mpmcq_init(mpmcq_t *_q, size_t _capacity);
+void mpmcq_destroy(mpmcq_t *_q);
+size_t mpmcq_capacity(mpmcq_t *_q);
+size_t mpmcq_size(mpmcq_t *_q);
+
+bool mpmcq_try_push(mpmcq_t *_q, void *_item);
+bool mpmcq_try_pop(mpmcq_t *_q, void **_item);
+size_t mpmcq_try_push_n(mpmcq_t *_q, void * const *_items, size_t _n);
+size_t mpmcq_try_pop_n(mpmcq_t *_q, void **_items, size_t _n);
+
+// Blocking versions: spin, then yield, until they succeed.
+void mpmcq_push(mpmcq_t *_q, void *_item);
+void *mpmcq_pop(mpmcq_t *_q);
+
+#endif // end of __C_MPMCQ_H__
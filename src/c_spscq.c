@@ -0,0 +1,137 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_spscq.c
+
+Single-producer single-consumer ring implementation.
+
+\**************************************************/
+
+#include "c_spscq.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+// Rounds _capacity up to a power of two, at least 2.
+void spscq_init(spscq_t *_q, size_t _capacity)
+{
+	size_t _cap = 2;
+	while (_cap < _capacity) {
+		_cap *= 2;
+	}
+	memset(_q, 0, sizeof(spscq_t));
+	_q->_slots = (void **) malloc(_cap * sizeof(void *));
+	if (_q->_slots == NULL) {
+		fprintf(stderr, "ERROR: spscq_init failed to allocate "
+			"%zu slots!\n", _cap);
+		exit(EXIT_FAILURE);
+	}
+	_q->_mask = _cap - 1;
+}
+
+void spscq_destroy(spscq_t *_q)
+{
+	free(_q->_slots);
+	memset(_q, 0, sizeof(spscq_t));
+}
+
+size_t spscq_capacity(spscq_t *_q)
+{
+	return _q->_mask + 1;
+}
+
+// Exact only when neither side is running.
+size_t spscq_size(spscq_t *_q)
+{
+	size_t _head = __atomic_load_n(&_q->_head, __ATOMIC_ACQUIRE);
+	size_t _tail = __atomic_load_n(&_q->_tail, __ATOMIC_ACQUIRE);
+	return _tail - _head;
+}
+
+// Returns how many free slots the producer may fill, refreshing its
+// copy of _head only when the copy does not show room for _want.
+static inline size_t _free_slots(spscq_t *_q, size_t _tail, size_t _want)
+{
+	size_t _cap = _q->_mask + 1;
+	size_t _room = _cap - (_tail - _q->_head_cache);
+	if (_room < _want) {
+		_q->_head_cache = __atomic_load_n(&_q->_head,
+						  __ATOMIC_ACQUIRE);
+		_room = _cap - (_tail - _q->_head_cache);
+	}
+	return _room;
+}
+
+// Same for the consumer and _tail.
+static inline size_t _used_slots(spscq_t *_q, size_t _head, size_t _want)
+{
+	size_t _ready = _q->_tail_cache - _head;
+	if (_ready < _want) {
+		_q->_tail_cache = __atomic_load_n(&_q->_tail,
+						  __ATOMIC_ACQUIRE);
+		_ready = _q->_tail_cache - _head;
+	}
+	return _ready;
+}
+
+// Returns false if the ring is full.
+bool spscq_push(spscq_t *_q, void *_item)
+{
+	size_t _tail = __atomic_load_n(&_q->_tail, __ATOMIC_RELAXED);
+	if (_free_slots(_q, _tail, 1) == 0) {
+		return false;
+	}
+	_q->_slots[_tail & _q->_mask] = _item;
+	__atomic_store_n(&_q->_tail, _tail + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+// Pushes as many of the _n items as fit and publishes them with one
+// store.  Returns how many were pushed.
+size_t spscq_push_n(spscq_t *_q, void * const *_items, size_t _n)
+{
+	size_t _tail = __atomic_load_n(&_q->_tail, __ATOMIC_RELAXED);
+	size_t _room = _free_slots(_q, _tail, _n);
+	size_t _i;
+
+	if (_n > _room) {
+		_n = _room;
+	}
+	for (_i = 0; _i < _n; _i++) {
+		_q->_slots[(_tail + _i) & _q->_mask] = _items[_i];
+	}
+	__atomic_store_n(&_q->_tail, _tail + _n, __ATOMIC_RELEASE);
+	return _n;
+}
+
+// Returns false if the ring is empty.
+bool spscq_pop(spscq_t *_q, void **_item)
+{
+	size_t _head = __atomic_load_n(&_q->_head, __ATOMIC_RELAXED);
+	if (_used_slots(_q, _head, 1) == 0) {
+		return false;
+	}
+	*_item = _q->_slots[_head & _q->_mask];
+	__atomic_store_n(&_q->_head, _head + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+// Pops up to _n items into _items and frees their slots with one
+// store.  Returns how many were popped.
+size_t spscq_pop_n(spscq_t *_q, void **_items, size_t _n)
+{
+	size_t _head = __atomic_load_n(&_q->_head, __ATOMIC_RELAXED);
+	size_t _ready = _used_slots(_q, _head, _n);
+	size_t _i;
+
+	if (_n > _ready) {
+		_n = _ready;
+	}
+	for (_i = 0; _i < _n; _i++) {
+		_items[_i] = _q->_slots[(_head + _i) & _q->_mask];
+	}
+	__atomic_store_n(&_q->_head, _head + _n, __ATOMIC_RELEASE);
+	return _n;
+}
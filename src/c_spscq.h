@@ -0,0 +1,51 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_spscq.h
+
+Bounded lock-free ring of pointers for exactly one producer
+thread and one consumer thread.  Each side owns its index on
+its own cache line and keeps a private copy of the other
+side's index, so it only reads the shared one (and takes the
+cache miss) when the copy says the ring looks full or empty.
+
+\**************************************************/
+
+#ifndef __C_SPSCQ_H__
+#define __C_SPSCQ_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SPSCQ_CACHE_LINE (64)
+
+// _head and _tail count items ever popped and pushed; slot i is
+// _slots[i & _mask].
+typedef struct c_spscq {
+	// Written by the consumer.
+	size_t _head __attribute__((aligned(SPSCQ_CACHE_LINE)));
+	size_t _tail_cache;	// consumer's last look at _tail
+	// Written by the producer.
+	size_t _tail __attribute__((aligned(SPSCQ_CACHE_LINE)));
+	size_t _head_cache;	// producer's last look at _head
+	// Read-only after spscq_init().
+	void **_slots __attribute__((aligned(SPSCQ_CACHE_LINE)));
+	size_t _mask;
+} __attribute__((aligned(SPSCQ_CACHE_LINE))) spscq_t;
+
+void spscq_init(spscq_t *_q, size_t _capacity);
+void spscq_destroy(spscq_t *_q);
+size_t spscq_capacity(spscq_t *_q);
+size_t spscq_size(spscq_t *_q);
+
+// Producer side.
+bool spscq_push(spscq_t *_q, void *_item);
+size_t spscq_push_n(spscq_t *_q, void * const *_items, size_t _n);
+
+// Consumer side.
+bool spscq_pop(spscq_t *_q, void **_item);
+size_t spscq_pop_n(spscq_t *_q, void **_items, size_t _n);
+
+#endif // end of __C_SPSCQ_H__
@@ -0,0 +1,162 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_wsdq.c
+
+Chase-Lev work-stealing deque implementation, with the
+memory orders of Le, Pop, Cohen and Zappa Nardelli,
+"Correct and Efficient Work-Stealing for Weak Memory
+Models" (PPoPP 2013).
+
+\**************************************************/
+
+#include "c_wsdq.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+static _wsdq_array_t *_alloc_array(size_t _capacity)
+{
+	_wsdq_array_t *_array = (_wsdq_array_t *)
+		malloc(sizeof(_wsdq_array_t) + _capacity * sizeof(void *));
+	if (_array == NULL) {
+		fprintf(stderr, "ERROR: wsdq failed to allocate "
+			"%zu slots!\n", _capacity);
+		exit(EXIT_FAILURE);
+	}
+	_array->_mask = _capacity - 1;
+	_array->_retired = NULL;
+	return _array;
+}
+
+static inline void *_get(_wsdq_array_t *_array, ssize_t _pos)
+{
+	return __atomic_load_n(&_array->_slots[_pos & _array->_mask],
+			       __ATOMIC_RELAXED);
+}
+
+static inline void _put(_wsdq_array_t *_array, ssize_t _pos, void *_item)
+{
+	__atomic_store_n(&_array->_slots[_pos & _array->_mask], _item,
+			 __ATOMIC_RELAXED);
+}
+
+// Rounds _capacity up to a power of two, at least WSDQ_MIN_CAPACITY.
+void wsdq_init(wsdq_t *_dq, size_t _capacity)
+{
+	size_t _cap = WSDQ_MIN_CAPACITY;
+	while (_cap < _capacity) {
+		_cap *= 2;
+	}
+	memset(_dq, 0, sizeof(wsdq_t));
+	_dq->_array = _alloc_array(_cap);
+}
+
+// Frees the array and every array it replaced.  No thread may use the
+// deque any more.
+void wsdq_destroy(wsdq_t *_dq)
+{
+	_wsdq_array_t *_array = _dq->_array;
+	while (_array != NULL) {
+		_wsdq_array_t *_retired = _array->_retired;
+		free(_array);
+		_array = _retired;
+	}
+	memset(_dq, 0, sizeof(wsdq_t));
+}
+
+// Exact only when no thread is using the deque.
+size_t wsdq_size(wsdq_t *_dq)
+{
+	ssize_t _bottom = __atomic_load_n(&_dq->_bottom, __ATOMIC_RELAXED);
+	ssize_t _top = __atomic_load_n(&_dq->_top, __ATOMIC_RELAXED);
+	return (_bottom > _top) ? (size_t) (_bottom - _top) : 0;
+}
+
+// Copies [_top, _bottom) into an array twice the size and publishes it.
+// The old array stays readable for thieves that loaded it already.
+static _wsdq_array_t *_grow(wsdq_t *_dq, _wsdq_array_t *_old,
+			    ssize_t _top, ssize_t _bottom)
+{
+	_wsdq_array_t *_array = _alloc_array(2 * (_old->_mask + 1));
+	ssize_t _i;
+
+	for (_i = _top; _i < _bottom; _i++) {
+		_put(_array, _i, _get(_old, _i));
+	}
+	_array->_retired = _old;
+	__atomic_store_n(&_dq->_array, _array, __ATOMIC_RELEASE);
+	return _array;
+}
+
+void wsdq_push(wsdq_t *_dq, void *_item)
+{
+	ssize_t _bottom = __atomic_load_n(&_dq->_bottom, __ATOMIC_RELAXED);
+	ssize_t _top = __atomic_load_n(&_dq->_top, __ATOMIC_ACQUIRE);
+	_wsdq_array_t *_array = __atomic_load_n(&_dq->_array,
+						__ATOMIC_RELAXED);
+
+	if (_bottom - _top > (ssize_t) _array->_mask) {
+		_array = _grow(_dq, _array, _top, _bottom);
+	}
+	_put(_array, _bottom, _item);
+	// Publishes the item to thieves that acquire _bottom.
+	__atomic_store_n(&_dq->_bottom, _bottom + 1, __ATOMIC_RELEASE);
+}
+
+// Takes the most recently pushed item.  Returns false if the deque is
+// empty or a thief took the last item first.
+bool wsdq_pop(wsdq_t *_dq, void **_item)
+{
+	ssize_t _bottom = __atomic_load_n(&_dq->_bottom, __ATOMIC_RELAXED) - 1;
+	_wsdq_array_t *_array = __atomic_load_n(&_dq->_array,
+						__ATOMIC_RELAXED);
+	ssize_t _top;
+	bool _taken = true;
+
+	// Claim the bottom slot before looking at _top, so that a thief
+	// racing for the same item sees the claim.
+	__atomic_store_n(&_dq->_bottom, _bottom, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	_top = __atomic_load_n(&_dq->_top, __ATOMIC_RELAXED);
+
+	if (_top > _bottom) {
+		__atomic_store_n(&_dq->_bottom, _bottom + 1, __ATOMIC_RELAXED);
+		return false;
+	}
+	*_item = _get(_array, _bottom);
+	if (_top == _bottom) {
+		// Last item: settle it with thieves on _top.
+		_taken = __atomic_compare_exchange_n(&_dq->_top, &_top, _top + 1,
+						     false, __ATOMIC_SEQ_CST,
+						     __ATOMIC_RELAXED);
+		__atomic_store_n(&_dq->_bottom, _bottom + 1, __ATOMIC_RELAXED);
+	}
+	return _taken;
+}
+
+// Takes the oldest item.  Returns WSDQ_STOLEN with the item in *_item,
+// WSDQ_EMPTY, or WSDQ_ABORT if another thread took it first.
+int wsdq_steal(wsdq_t *_dq, void **_item)
+{
+	ssize_t _top = __atomic_load_n(&_dq->_top, __ATOMIC_ACQUIRE);
+	ssize_t _bottom;
+	_wsdq_array_t *_array;
+	void *_candidate;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	_bottom = __atomic_load_n(&_dq->_bottom, __ATOMIC_ACQUIRE);
+	if (_top >= _bottom) {
+		return WSDQ_EMPTY;
+	}
+	_array = __atomic_load_n(&_dq->_array, __ATOMIC_ACQUIRE);
+	_candidate = _get(_array, _top);
+	if (!__atomic_compare_exchange_n(&_dq->_top, &_top, _top + 1, false,
+					 __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+		return WSDQ_ABORT;
+	}
+	*_item = _candidate;
+	return WSDQ_STOLEN;
+}
@@ -0,0 +1,57 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_wsdq.h
+
+Lock-free Chase-Lev work-stealing deque of pointers.  The
+owning thread pushes and pops at the bottom without atomic
+read-modify-writes except when taking the last item; any
+other thread steals from the top with one CAS.  The array
+doubles when full.  Thieves may still be reading an array
+that was replaced, so old arrays are only freed by
+wsdq_destroy().
+
+\**************************************************/
+
+#ifndef __C_WSDQ_H__
+#define __C_WSDQ_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+#define WSDQ_CACHE_LINE (64)
+#define WSDQ_MIN_CAPACITY (64)
+
+// Results of wsdq_steal().
+#define WSDQ_STOLEN (1)
+#define WSDQ_EMPTY (0)
+#define WSDQ_ABORT (-1)		// lost a race, worth retrying
+
+typedef struct _wsdq_array {
+	size_t _mask;		// capacity - 1, capacity a power of two
+	struct _wsdq_array *_retired;	// array this one replaced
+	void *_slots[];
+} _wsdq_array_t;
+
+// Items live at positions [_top, _bottom) of _array.
+typedef struct c_wsdq {
+	ssize_t _top __attribute__((aligned(WSDQ_CACHE_LINE)));
+	ssize_t _bottom __attribute__((aligned(WSDQ_CACHE_LINE)));
+	_wsdq_array_t *_array;
+} __attribute__((aligned(WSDQ_CACHE_LINE))) wsdq_t;
+
+void wsdq_init(wsdq_t *_dq, size_t _capacity);
+void wsdq_destroy(wsdq_t *_dq);
+size_t wsdq_size(wsdq_t *_dq);
+
+// Owner only.
+void wsdq_push(wsdq_t *_dq, void *_item);
+bool wsdq_pop(wsdq_t *_dq, void **_item);
+
+// Any thread.
+int wsdq_steal(wsdq_t *_dq, void **_item);
+
+#endif // end of __C_WSDQ_H__
@@ -0,0 +1,190 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_wsp.c
+
+Work-stealing task pool implementation.
+
+\**************************************************/
+
+#include "c_wsp.h"
+
+#include <assert.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+// The worker running on this thread, if any.
+static __thread _wsp_worker_t *_self = NULL;
+
+static inline uint64_t _rand(uint64_t *_state)
+{
+	uint64_t _x = *_state;
+	_x ^= _x >> 12;
+	_x ^= _x << 25;
+	_x ^= _x >> 27;
+	*_state = _x;
+	return _x * 0x2545F4914F6CDD1DULL;
+}
+
+static void _run(wsp_t *_pool, _wsp_task_t *_task)
+{
+	_task->_fn(_task->_arg);
+	free(_task);
+	__atomic_sub_fetch(&_pool->_pending, 1, __ATOMIC_RELEASE);
+}
+
+// Tries the shared queue, then every worker other than _skip starting
+// from a random one.  Returns NULL if nothing was found.
+static _wsp_task_t *_find_task(wsp_t *_pool, _wsp_worker_t *_skip,
+			       uint64_t *_seed)
+{
+	void *_task;
+	size_t _start;
+	size_t _i;
+
+	if (mpmcq_try_pop(&_pool->_inject, &_task)) {
+		return (_wsp_task_t *) _task;
+	}
+	_start = _rand(_seed) % _pool->_num_workers;
+	for (_i = 0; _i < _pool->_num_workers; _i++) {
+		_wsp_worker_t *_victim =
+			&_pool->_workers[(_start + _i) % _pool->_num_workers];
+		int _ret;
+		if (_victim == _skip) {
+			continue;
+		}
+		do {
+			_ret = wsdq_steal(&_victim->_dq, &_task);
+		} while (_ret == WSDQ_ABORT);
+		if (_ret == WSDQ_STOLEN) {
+			return (_wsp_task_t *) _task;
+		}
+	}
+	return NULL;
+}
+
+static void *_worker_main(void *_arg)
+{
+	_wsp_worker_t *_worker = (_wsp_worker_t *) _arg;
+	wsp_t *_pool = _worker->_pool;
+	size_t _idle = 0;
+	void *_task;
+
+	_self = _worker;
+	while (!__atomic_load_n(&_pool->_stop, __ATOMIC_ACQUIRE)) {
+		if (!wsdq_pop(&_worker->_dq, &_task)) {
+			_task = _find_task(_pool, _worker, &_worker->_seed);
+		}
+		if (_task != NULL) {
+			_run(_pool, (_wsp_task_t *) _task);
+			_idle = 0;
+		} else if (++_idle > WSP_IDLE_SPINS) {
+			sched_yield();
+		}
+	}
+	_self = NULL;
+	return NULL;
+}
+
+// Starts _num_workers threads, at least one.
+void wsp_init(wsp_t *_pool, size_t _num_workers)
+{
+	size_t _i;
+
+	if (_num_workers == 0) {
+		_num_workers = 1;
+	}
+	memset(_pool, 0, sizeof(wsp_t));
+	mpmcq_init(&_pool->_inject, WSP_INJECT_CAPACITY);
+	_pool->_num_workers = _num_workers;
+	if (posix_memalign((void **) &_pool->_workers, WSDQ_CACHE_LINE,
+			   _num_workers * sizeof(_wsp_worker_t)) != 0) {
+		fprintf(stderr, "ERROR: wsp_init failed to allocate "
+			"%zu workers!\n", _num_workers);
+		exit(EXIT_FAILURE);
+	}
+	for (_i = 0; _i < _num_workers; _i++) {
+		_wsp_worker_t *_worker = &_pool->_workers[_i];
+		wsdq_init(&_worker->_dq, 0);
+		_worker->_pool = _pool;
+		_worker->_seed = 0x9E3779B97F4A7C15ULL * (_i + 1);
+		_worker->_id = _i;
+	}
+	for (_i = 0; _i < _num_workers; _i++) {
+		if (pthread_create(&_pool->_workers[_i]._thread, NULL,
+				   _worker_main, &_pool->_workers[_i]) != 0) {
+			fprintf(stderr, "ERROR: wsp_init failed to start "
+				"worker %zu!\n", _i);
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+// Waits for every submitted task, then stops the workers.
+void wsp_destroy(wsp_t *_pool)
+{
+	size_t _i;
+
+	wsp_wait(_pool);
+	__atomic_store_n(&_pool->_stop, 1, __ATOMIC_RELEASE);
+	for (_i = 0; _i < _pool->_num_workers; _i++) {
+		pthread_join(_pool->_workers[_i]._thread, NULL);
+		wsdq_destroy(&_pool->_workers[_i]._dq);
+	}
+	free(_pool->_workers);
+	mpmcq_destroy(&_pool->_inject);
+	memset(_pool, 0, sizeof(wsp_t));
+}
+
+// Queues _fn(_arg).  Called from a task, it goes to the bottom of the
+// running worker's deque; otherwise to the shared queue.
+void wsp_submit(wsp_t *_pool, wsp_fn_t _fn, void *_arg)
+{
+	_wsp_task_t *_task = (_wsp_task_t *) malloc(sizeof(_wsp_task_t));
+
+	assert(_task != NULL);
+	_task->_fn = _fn;
+	_task->_arg = _arg;
+	__atomic_add_fetch(&_pool->_pending, 1, __ATOMIC_RELAXED);
+	if (_self != NULL && _self->_pool == _pool) {
+		wsdq_push(&_self->_dq, _task);
+	} else {
+		mpmcq_push(&_pool->_inject, _task);
+	}
+}
+
+// Runs tasks alongside the workers until every task submitted so far,
+// and every task those submit, has finished.  Must not be called from
+// a task of the same pool, whose own unfinished task would keep it
+// waiting forever.
+void wsp_wait(wsp_t *_pool)
+{
+	uint64_t _seed = (uintptr_t) &_seed;
+	size_t _idle = 0;
+	_wsp_task_t *_task;
+
+	assert(_self == NULL || _self->_pool != _pool);
+	while (__atomic_load_n(&_pool->_pending, __ATOMIC_ACQUIRE) > 0) {
+		_task = _find_task(_pool, NULL, &_seed);
+		if (_task != NULL) {
+			_run(_pool, _task);
+			_idle = 0;
+		} else if (++_idle > WSP_IDLE_SPINS) {
+			sched_yield();
+		}
+	}
+}
+
+// Returns the index of the calling worker in [0, number of workers),
+// or the number of workers when called from outside the pool (tasks
+// run by wsp_wait()), so that tasks can keep per-worker state in an
+// array of number of workers + 1 entries without locks.
+size_t wsp_worker_id(wsp_t *_pool)
+{
+	if (_self != NULL && _self->_pool == _pool) {
+		return _self->_id;
+	}
+	return _pool->_num_workers;
+}
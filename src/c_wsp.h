@@ -0,0 +1,65 @@
+/**************************************************\
+
+Author: Ji-Yong Shin (jiyong.shin@gmail.com)
+
+c_wsp.h
+
+Work-stealing task pool.  Every worker thread owns a wsdq_t
+and runs its own tasks newest first; an idle worker steals
+the oldest task of a random other worker.  Tasks submitted
+from outside the pool go through a shared mpmcq_t, and tasks
+submitted from inside a task go to the running worker's own
+deque, so recursive splitting never touches a central queue.
+
+\**************************************************/
+
+#ifndef __C_WSP_H__
+#define __C_WSP_H__
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "c_mpmcq.h"
+#include "c_wsdq.h"
+
+// Slots of the queue for tasks submitted from outside the pool.
+#ifndef WSP_INJECT_CAPACITY
+#define WSP_INJECT_CAPACITY (4096)
+#endif
+// Empty rounds an idle worker spins through before it starts yielding.
+#ifndef WSP_IDLE_SPINS
+#define WSP_IDLE_SPINS (64)
+#endif
+
+typedef void (*wsp_fn_t)(void *_arg);
+
+typedef struct _wsp_task {
+	wsp_fn_t _fn;
+	void *_arg;
+} _wsp_task_t;
+
+typedef struct _wsp_worker {
+	wsdq_t _dq;
+	struct c_wsp *_pool;
+	pthread_t _thread;
+	uint64_t _seed;		// victim selection
+	size_t _id;
+} _wsp_worker_t;
+
+typedef struct c_wsp {
+	mpmcq_t _inject;
+	_wsp_worker_t *_workers;
+	size_t _num_workers;
+	size_t _pending;	// submitted but not finished
+	int _stop;
+} wsp_t;
+
+void wsp_init(wsp_t *_pool, size_t _num_workers);
+void wsp_destroy(wsp_t *_pool);
+void wsp_submit(wsp_t *_pool, wsp_fn_t _fn, void *_arg);
+void wsp_wait(wsp_t *_pool);
+size_t wsp_worker_id(wsp_t *_pool);
+
+#endif // end of __C_WSP_H__